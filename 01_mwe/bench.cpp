@@ -0,0 +1,283 @@
+#include "example.hpp"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+/*
+ * Headless benchmark, times every creation stage and a fixed number of frames after a warm-up.
+ * Runs without a window, so it works with a software ICD on a headless machine.
+ */
+
+static double percentile(const std::vector<double> & sorted, double fraction)
+{
+    return sorted[(size_t) (fraction * (sorted.size() - 1u) + 0.5)];
+}
+
+/* Command line of one benchmark run, --samples may request several runs */
+struct BenchmarkOptions
+{
+    uint32_t        warmupFrames = 100u;
+    uint32_t        measuredFrames = 1000u;
+    uint32_t        gridCount = 0u;
+    uint32_t        instancesPerDraw = 0u;
+    uint32_t        threadCount = 0u;
+    uint32_t        framesInFlight = 2u;
+    uint32_t        initThreadCount = 0u;
+    const char *    devicePreference = nullptr;
+    const char *    meshPath = nullptr;
+    VkFormat        depthFormat = VK_FORMAT_D32_SFLOAT;
+    VkBool32        gpuCulling = VK_FALSE;
+    VkBool32        depthPrepass = VK_FALSE;
+};
+
+struct BenchmarkResult
+{
+    uint32_t                samples;        /* sample count the device actually used */
+    std::vector<GraphTask>  stages;
+    double                  startupMs;
+    double                  framesPerSecond;
+    double                  meanMs;
+    std::vector<double>     sortedMs;
+};
+
+static BenchmarkResult runBenchmark(const BenchmarkOptions & options, uint32_t sampleCount)
+{
+    Example vulkan_example;
+    BenchmarkResult benchmark;
+
+    if (0u != options.gridCount)
+    {
+        vulkan_example.createGridScene(options.gridCount);
+    }
+    vulkan_example.setInstancesPerDraw(options.instancesPerDraw);
+    vulkan_example.setRecordingThreads(options.threadCount);
+    vulkan_example.setGpuCulling(options.gpuCulling);
+    vulkan_example.setDepthPrepass(options.depthPrepass);
+    vulkan_example.setDepthFormat(options.depthFormat);
+    vulkan_example.setSampleCount(sampleCount);
+    vulkan_example.setFramesInFlight(options.framesInFlight);
+    vulkan_example.setHeadless(VK_TRUE);
+    if (nullptr != options.meshPath)
+    {
+        vulkan_example.setMeshFile(options.meshPath);
+    }
+    if (nullptr != options.devicePreference)
+    {
+        vulkan_example.setDevicePreference(options.devicePreference);
+    }
+
+    /* Same initialization graph as main.cpp, every task is timed; --init-threads 1 runs it serially */
+    ThreadPool initPool;
+    if (1u != options.initThreadCount)
+    {
+        initPool.init((0u == options.initThreadCount) ? 0u : (options.initThreadCount - 1u));
+    }
+
+    TaskGraph initGraph;
+    vulkan_example.buildInitGraph(initGraph);
+    initGraph.run(initPool);
+    initPool.destroy();
+
+    benchmark.stages = initGraph.getTasks();
+    benchmark.startupMs = initGraph.getWallMs();
+    benchmark.samples = vulkan_example.getSampleCount();
+
+    /* Warm-up fills the pipeline and lets drivers finish lazy work, it is not measured */
+    for (uint32_t i = 0u; i < options.warmupFrames; i++)
+    {
+        vulkan_example.drawOffscreenFrame();
+    }
+    vulkan_example.waitIdle();
+
+    std::vector<double> frameMs(options.measuredFrames);
+    auto start = std::chrono::steady_clock::now();
+    auto previous = start;
+    for (uint32_t i = 0u; i < options.measuredFrames; i++)
+    {
+        vulkan_example.drawOffscreenFrame();
+
+        auto now = std::chrono::steady_clock::now();
+        frameMs[i] = std::chrono::duration<double, std::milli>(now - previous).count();
+        previous = now;
+    }
+    vulkan_example.waitIdle();
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    benchmark.framesPerSecond = options.measuredFrames / totalSeconds;
+
+    benchmark.sortedMs = frameMs;
+    std::sort(benchmark.sortedMs.begin(), benchmark.sortedMs.end());
+    benchmark.meanMs = 0.0;
+    for (auto ms : frameMs)
+    {
+        benchmark.meanMs += ms;
+    }
+    benchmark.meanMs /= options.measuredFrames;
+
+    vulkan_example.cleanup();
+
+    return benchmark;
+}
+
+int main(int argc, char ** argv)
+{
+    BenchmarkOptions options;
+    const char * outputPath = nullptr;
+    std::vector<uint32_t> sampleCounts;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "--warmup")) && ((i + 1) < argc))
+        {
+            options.warmupFrames = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--frames")) && ((i + 1) < argc))
+        {
+            options.measuredFrames = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--grid")) && ((i + 1) < argc))
+        {
+            options.gridCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--batch")) && ((i + 1) < argc))
+        {
+            options.instancesPerDraw = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--threads")) && ((i + 1) < argc))
+        {
+            options.threadCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--frames-in-flight")) && ((i + 1) < argc))
+        {
+            options.framesInFlight = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--output")) && ((i + 1) < argc))
+        {
+            outputPath = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--init-threads")) && ((i + 1) < argc))
+        {
+            options.initThreadCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if (0 == strcmp(argv[i], "--gpu-cull"))
+        {
+            options.gpuCulling = VK_TRUE;
+        }
+        else if (0 == strcmp(argv[i], "--depth-prepass"))
+        {
+            options.depthPrepass = VK_TRUE;
+        }
+        else if ((0 == strcmp(argv[i], "--device")) && ((i + 1) < argc))
+        {
+            options.devicePreference = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--mesh")) && ((i + 1) < argc))
+        {
+            options.meshPath = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--depth-format")) && ((i + 1) < argc))
+        {
+            if (!Example::parseDepthFormat(argv[++i], options.depthFormat))
+            {
+                std::cerr << "Unknown depth format " << argv[i] << ", expected d16, d24s8 or d32" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if ((0 == strcmp(argv[i], "--samples")) && ((i + 1) < argc))
+        {
+            /* Comma separated list, e.g. 1,2,4,8: one complete run per sample count */
+            char * next = argv[++i];
+            while ('\0' != *next)
+            {
+                sampleCounts.push_back((uint32_t) strtoul(next, &next, 10));
+                if (',' == *next)
+                {
+                    next++;
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (0u == options.measuredFrames)
+    {
+        options.measuredFrames = 1u;
+    }
+    if (sampleCounts.empty())
+    {
+        sampleCounts.push_back(1u);
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (auto sampleCount : sampleCounts)
+    {
+        results.push_back(runBenchmark(options, sampleCount));
+    }
+
+    for (const auto & benchmark : results)
+    {
+        const std::vector<double> & sorted = benchmark.sortedMs;
+
+        std::cout << std::endl << "Startup stages:" << std::endl;
+        for (const auto & stage : benchmark.stages)
+        {
+            std::cout << "  " << stage.name << ": " << stage.durationMs << " ms (started at " << stage.startMs << " ms)" << std::endl;
+        }
+        std::cout << "Startup wall time: " << benchmark.startupMs << " ms" << std::endl;
+        std::cout << std::dec << "MSAA: " << benchmark.samples << "x" << std::endl;
+        std::cout << "Frames: " << options.warmupFrames << " warm-up, " << options.measuredFrames << " measured, " << benchmark.framesPerSecond << " frames/s" << std::endl;
+        std::cout << "Frame ms min/mean/p50/p95/p99/max: " << sorted.front() << "/" << benchmark.meanMs << "/" << percentile(sorted, 0.50) << "/"
+                  << percentile(sorted, 0.95) << "/" << percentile(sorted, 0.99) << "/" << sorted.back() << std::endl;
+    }
+
+    /* Cost of anti-aliasing relative to the first run, usually the 1x baseline */
+    if (results.size() > 1u)
+    {
+        std::cout << std::endl << "Sample count sweep, mean frame ms (cost over " << results[0u].samples << "x):" << std::endl;
+        for (const auto & benchmark : results)
+        {
+            std::cout << "  " << benchmark.samples << "x: " << benchmark.meanMs << " ms, p95 " << percentile(benchmark.sortedMs, 0.95)
+                      << " ms (+" << (benchmark.meanMs - results[0u].meanMs) << " ms)" << std::endl;
+        }
+    }
+
+    if (nullptr != outputPath)
+    {
+        /* The first run keeps the established layout, a sweep adds one entry per sample count */
+        const BenchmarkResult & benchmark = results[0u];
+        const std::vector<double> & sorted = benchmark.sortedMs;
+
+        std::ofstream file(outputPath, std::ios::trunc);
+        file << "{\n  \"stages_ms\": {";
+        for (size_t i = 0u; i < benchmark.stages.size(); i++)
+        {
+            file << ((0u == i) ? "\n" : ",\n") << "    \"" << benchmark.stages[i].name << "\": " << benchmark.stages[i].durationMs;
+        }
+        file << "\n  },\n"
+             << "  \"startup_ms\": " << benchmark.startupMs << ",\n"
+             << "  \"samples\": " << benchmark.samples << ",\n"
+             << "  \"warmup_frames\": " << options.warmupFrames << ",\n"
+             << "  \"measured_frames\": " << options.measuredFrames << ",\n"
+             << "  \"frames_per_second\": " << benchmark.framesPerSecond << ",\n"
+             << "  \"frame_ms\": {\"min\": " << sorted.front() << ", \"mean\": " << benchmark.meanMs << ", \"p50\": " << percentile(sorted, 0.50)
+             << ", \"p95\": " << percentile(sorted, 0.95) << ", \"p99\": " << percentile(sorted, 0.99) << ", \"max\": " << sorted.back() << "}";
+        if (results.size() > 1u)
+        {
+            file << ",\n  \"msaa\": [";
+            for (size_t i = 0u; i < results.size(); i++)
+            {
+                file << ((0u == i) ? "\n" : ",\n") << "    {\"samples\": " << results[i].samples << ", \"frames_per_second\": " << results[i].framesPerSecond
+                     << ", \"mean_ms\": " << results[i].meanMs << ", \"p95_ms\": " << percentile(results[i].sortedMs, 0.95) << "}";
+            }
+            file << "\n  ]";
+        }
+        file << "\n}\n";
+        std::cout << "Results written to " << outputPath << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+# Writes SPIR-V binaries into a C++ header as constexpr uint32_t arrays usable directly as pCode.
+#   cmake -DOUTPUT=<header> -DSPIRV_FILES=<a.spv|b.spv|...> -P embed_spirv.cmake
+# Every <name>.spv becomes EMBEDDED_SPIRV_<NAME>.
+
+STRING(REPLACE "|" ";" SPIRV_FILES "${SPIRV_FILES}")
+
+SET(CONTENT "/* Generated by cmake/embed_spirv.cmake, do not edit */\n#include <cstdint>\n\n#ifndef EMBEDDED_SHADERS_GUARD\n#define EMBEDDED_SHADERS_GUARD\n")
+
+FOREACH(SPIRV_FILE ${SPIRV_FILES})
+    GET_FILENAME_COMPONENT(NAME ${SPIRV_FILE} NAME_WE)
+    STRING(TOUPPER ${NAME} NAME)
+
+    FILE(READ ${SPIRV_FILE} BYTES HEX)
+    STRING(LENGTH "${BYTES}" HEX_LENGTH)
+    MATH(EXPR REMAINDER "${HEX_LENGTH} % 8")
+    IF((HEX_LENGTH EQUAL 0) OR (NOT REMAINDER EQUAL 0))
+        MESSAGE(FATAL_ERROR "${SPIRV_FILE} is not a SPIR-V binary, its size is not a multiple of 4 bytes")
+    ENDIF()
+
+    # SPIR-V words are little endian
+    SET(WORDS "")
+    SET(COLUMN 0)
+    MATH(EXPR LAST "${HEX_LENGTH} - 8")
+    FOREACH(OFFSET RANGE 0 ${LAST} 8)
+        STRING(SUBSTRING "${BYTES}" ${OFFSET} 8 WORD)
+        STRING(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1" WORD "${WORD}")
+        IF(COLUMN EQUAL 0)
+            STRING(APPEND WORDS "\n   ")
+        ENDIF()
+        STRING(APPEND WORDS " ${WORD},")
+        MATH(EXPR COLUMN "(${COLUMN} + 1) % 8")
+    ENDFOREACH()
+
+    STRING(APPEND CONTENT "\nalignas(4) static constexpr uint32_t EMBEDDED_SPIRV_${NAME}[] =\n{${WORDS}\n};\n")
+ENDFOREACH()
+
+STRING(APPEND CONTENT "#endif\n")
+
+# Only touch the header when it changes, so unrelated shader rebuilds do not recompile everything
+SET(PREVIOUS "")
+IF(EXISTS ${OUTPUT})
+    FILE(READ ${OUTPUT} PREVIOUS)
+ENDIF()
+IF(NOT "${PREVIOUS}" STREQUAL "${CONTENT}")
+    FILE(WRITE ${OUTPUT} "${CONTENT}")
+ENDIF()
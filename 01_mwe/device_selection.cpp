@@ -0,0 +1,178 @@
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include "device_selection.hpp"
+
+const char * getDeviceTypeName(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:      return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:    return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:       return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:               return "cpu";
+        default:                                        return "other";
+    }
+}
+
+static uint64_t getDeviceTypeRank(VkPhysicalDeviceType type)
+{
+    switch (type)
+    {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:      return 4u;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:    return 3u;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:       return 2u;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:               return 1u;
+        default:                                        return 0u;
+    }
+}
+
+static DeviceCandidate inspectDevice(VkPhysicalDevice device, uint32_t index, const std::vector<const char *> & requiredExtensions, VkSurfaceKHR surface)
+{
+    DeviceCandidate candidate = {};
+    candidate.index = index;
+    candidate.suitable = true;
+    vkGetPhysicalDeviceProperties(device, &candidate.properties);
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+    for (uint32_t i = 0u; i < memoryProperties.memoryHeapCount; i++)
+    {
+        if (0u != (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+        {
+            candidate.deviceLocalBytes = std::max(candidate.deviceLocalBytes, memoryProperties.memoryHeaps[i].size);
+        }
+    }
+
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+    for (const char * required : requiredExtensions)
+    {
+        auto found = std::find_if(extensions.begin(), extensions.end(),
+                                  [required](const VkExtensionProperties & extension) { return 0 == strcmp(extension.extensionName, required); });
+        if (extensions.end() == found)
+        {
+            candidate.suitable = false;
+            candidate.rejectReason = std::string("missing ") + required;
+            return candidate;
+        }
+    }
+
+    uint32_t familyCount;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+
+    bool graphics = false;
+    bool present = (VK_NULL_HANDLE == surface);
+    for (uint32_t i = 0u; i < familyCount; i++)
+    {
+        VkQueueFlags flags = families[i].queueFlags;
+        graphics |= (0u != (flags & VK_QUEUE_GRAPHICS_BIT));
+        candidate.dedicatedTransferQueue |= ((0u != (flags & VK_QUEUE_TRANSFER_BIT)) && (0u == (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))));
+
+        if (VK_NULL_HANDLE != surface)
+        {
+            VkBool32 presentSupport = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+            present |= (VK_TRUE == presentSupport);
+        }
+    }
+
+    if (!graphics)
+    {
+        candidate.suitable = false;
+        candidate.rejectReason = "no graphics queue";
+    }
+    else if (!present)
+    {
+        candidate.suitable = false;
+        candidate.rejectReason = "cannot present to the window";
+    }
+    else
+    {
+        /* Type dominates, then device local memory in MiB, a DMA transfer queue breaks ties */
+        uint64_t deviceLocalMiB = std::min<uint64_t>(candidate.deviceLocalBytes >> 20u, (1ull << 40u) - 1u);
+        candidate.score = (getDeviceTypeRank(candidate.properties.deviceType) << 48u) | (deviceLocalMiB << 1u) |
+                          (candidate.dedicatedTransferQueue ? 1u : 0u);
+    }
+
+    return candidate;
+}
+
+std::vector<DeviceCandidate> rankPhysicalDevices(const std::vector<VkPhysicalDevice> & devices,
+                                                 const std::vector<const char *> & requiredExtensions, VkSurfaceKHR surface)
+{
+    std::vector<DeviceCandidate> candidates;
+    for (uint32_t i = 0u; i < devices.size(); i++)
+    {
+        candidates.push_back(inspectDevice(devices[i], i, requiredExtensions, surface));
+    }
+
+    for (const auto & candidate : candidates)
+    {
+        std::cout << std::dec << "Device " << candidate.index << ": " << candidate.properties.deviceName << " ("
+                  << getDeviceTypeName(candidate.properties.deviceType) << ", " << (candidate.deviceLocalBytes >> 20u) << " MiB device local)";
+        if (candidate.suitable)
+        {
+            std::cout << ", score " << candidate.score << std::endl;
+        }
+        else
+        {
+            std::cout << ", unsuitable: " << candidate.rejectReason << std::endl;
+        }
+    }
+
+    return candidates;
+}
+
+static std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char) tolower(c); });
+    return text;
+}
+
+uint32_t selectPhysicalDevice(const std::vector<DeviceCandidate> & candidates, const std::string & preference)
+{
+    if (!preference.empty())
+    {
+        bool isIndex = std::all_of(preference.begin(), preference.end(), [](unsigned char c) { return 0 != isdigit(c); });
+        for (const auto & candidate : candidates)
+        {
+            bool matches = isIndex ? (candidate.index == (uint32_t) strtoul(preference.c_str(), nullptr, 10))
+                                   : (std::string::npos != toLower(candidate.properties.deviceName).find(toLower(preference)));
+            if (!matches)
+            {
+                continue;
+            }
+            if (!candidate.suitable)
+            {
+                throw std::runtime_error("Requested device is not suitable!");
+            }
+            return candidate.index;
+        }
+
+        throw std::runtime_error("Requested device not found!");
+    }
+
+    const DeviceCandidate * best = nullptr;
+    for (const auto & candidate : candidates)
+    {
+        if (candidate.suitable && ((nullptr == best) || (candidate.score > best->score)))
+        {
+            best = &candidate;
+        }
+    }
+
+    if (nullptr == best)
+    {
+        throw std::runtime_error("No suitable Vulkan device found!");
+    }
+    return best->index;
+}
@@ -0,0 +1,37 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#ifndef DEVICE_SELECTION_GUARD
+#define DEVICE_SELECTION_GUARD
+
+/* Environment variable overriding the device choice, same syntax as setDevicePreference() */
+#define DEVICE_PREFERENCE_ENV   "MWE_DEVICE"
+
+/* What was found out about one physical device, devices that cannot run the example have suitable == false */
+struct DeviceCandidate
+{
+    uint32_t                    index;
+    VkPhysicalDeviceProperties  properties;
+    VkDeviceSize                deviceLocalBytes;
+    bool                        dedicatedTransferQueue;
+    bool                        suitable;
+    std::string                 rejectReason;
+    uint64_t                    score;
+};
+
+/*
+ * Scores every device: type first (discrete > integrated > virtual > CPU), then the size of the largest
+ * device local heap, then the queue families on offer. Devices without a graphics queue, without the required
+ * extensions or, when surface is not VK_NULL_HANDLE, without presentation support are rejected.
+ */
+std::vector<DeviceCandidate> rankPhysicalDevices(const std::vector<VkPhysicalDevice> & devices,
+                                                 const std::vector<const char *> & requiredExtensions, VkSurfaceKHR surface);
+
+/* preference is a device index or a case insensitive part of the device name, empty picks the best score */
+uint32_t selectPhysicalDevice(const std::vector<DeviceCandidate> & candidates, const std::string & preference);
+
+const char * getDeviceTypeName(VkPhysicalDeviceType type);
+#endif
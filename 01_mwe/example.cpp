@@ -1,1015 +1,2838 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-#include "example.hpp"
-
-#if defined USE_GLM
-Vertex my_cube[] =
-{
-    /* front side - red */
-    {VERTEX_1, COLOR_RED}, {VERTEX_4, COLOR_RED}, {VERTEX_3, COLOR_RED},
-    {VERTEX_1, COLOR_RED}, {VERTEX_3, COLOR_RED}, {VERTEX_2, COLOR_RED},
-    
-    #if 1
-    /* right side - green */
-    {VERTEX_2, COLOR_GREEN}, {VERTEX_3, COLOR_GREEN}, {VERTEX_7, COLOR_GREEN},
-    {VERTEX_2, COLOR_GREEN}, {VERTEX_7, COLOR_GREEN}, {VERTEX_6, COLOR_GREEN},
-    
-    /* left side - blue */
-    {VERTEX_5, COLOR_BLUE}, {VERTEX_8, COLOR_BLUE}, {VERTEX_4, COLOR_BLUE},
-    {VERTEX_5, COLOR_BLUE}, {VERTEX_4, COLOR_BLUE}, {VERTEX_1, COLOR_BLUE},
-
-    /* top side - yellow */
-    {VERTEX_4, COLOR_RG}, {VERTEX_8, COLOR_RG}, {VERTEX_7, COLOR_RG},
-    {VERTEX_4, COLOR_RG}, {VERTEX_7, COLOR_RG}, {VERTEX_3, COLOR_RG},
-    
-    /* bottom side - magenta */
-    {VERTEX_5, COLOR_RB}, {VERTEX_1, COLOR_RB}, {VERTEX_2, COLOR_RB},
-    {VERTEX_5, COLOR_RB}, {VERTEX_2, COLOR_RB}, {VERTEX_6, COLOR_RB},
-
-    /* back side - cyan */
-    {VERTEX_7, COLOR_GB}, {VERTEX_8, COLOR_GB}, {VERTEX_6, COLOR_GB},
-    {VERTEX_6, COLOR_GB}, {VERTEX_8, COLOR_GB}, {VERTEX_5, COLOR_GB},
-    #endif
-};
-#endif
-
-uint32_t Example::getCubeSizeBytes(void)
-{
-    return sizeof(my_cube);
-}
-
-uint32_t Example::getCubeVerticesCount(void)
-{
-    return sizeof(my_cube) / sizeof(my_cube[0]);
-}
-
-static void printResult(VkResult result, std::string message)
-{
-    switch (result)
-    {
-    case VK_SUCCESS:
-        std::cout << message + ":[0] VK_SUCCESS"<< std::endl;
-        break;
-    case VK_ERROR_EXTENSION_NOT_PRESENT:
-        std::cout << message + ":[-7] VK_ERROR_EXTENSION_NOT_PRESENT" << std::endl;
-        break;
-    default:
-        std::cout << result << std::endl;
-        break;
-    }
-}
-
-int32_t Example::createWindow(void)
-{
-    VkResult result;
-
-    if (!glfwInit())
-        return -1;
-    
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    m_window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
-
-    if (!m_window)
-    {
-        std::cout << "Window creation failed!" << std::endl;
-        return -1;
-    }
-    
-    result = glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface);
-    printResult(result, "Surface creation result");
-
-    return 0;
-}
-
-void Example::run(void)
-{
-    while (!glfwWindowShouldClose(m_window))
-    {
-        glfwPollEvents();
-        drawFrame();
-    }
-}
-
-void Example::createInstance(void)
-{
-    VkResult result;
-    uint32_t extension_count;
-    result = vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
-    if (VK_SUCCESS != result)
-    {
-        std::cout << "vkEnumerateInstanceExtensionProperties error. Unable to get extension count." << std::endl;
-    }
-
-    m_available_extensions.resize(extension_count);
-
-    result = vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, &m_available_extensions[0]);
-    if (VK_SUCCESS != result)
-    {
-        std::cout << "vkEnumerateInstanceExtensionProperties error. Unable to get extensions." << std::endl;
-    }
-
-    for (auto const& extension : m_available_extensions)
-    {
-        std::cout << extension.extensionName << std::endl;
-    }
-
-    uint32_t property_count;
-    std::vector<VkLayerProperties> available_layers;
-    result = vkEnumerateInstanceLayerProperties(&property_count, nullptr);
-    printResult(result, "Enumerating layer properties");
-    available_layers.resize(property_count);
-    result = vkEnumerateInstanceLayerProperties(&property_count, &available_layers[0]);
-
-    for (auto const& layer : available_layers)
-    {
-        std::cout << layer.layerName << std::endl;
-    }
-
-    VkInstanceCreateInfo ici = 
-    {
-        .sType                      = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
-        .pNext                      = nullptr,
-        .flags                      = 0,
-        .pApplicationInfo           = nullptr,
-        .enabledLayerCount          = (uint32_t) m_required_validation_layers.size(),
-        .ppEnabledLayerNames        = &m_required_validation_layers[0],
-        .enabledExtensionCount      = (uint32_t) m_required_instance_extensions.size(),
-        .ppEnabledExtensionNames    = &m_required_instance_extensions[0],
-    };
-
-    result = vkCreateInstance(&ici, nullptr, &m_instance);
-
-    printResult(result, "Instance creation result");   
-}
-
-void Example::createDevice(void)
-{
-    VkResult result;
-    uint32_t best_device = 0u;
-
-    uint32_t queue_count;
-    std::vector<VkQueueFamilyProperties> queue_family_properties;
-
-    uint32_t device_count;
-    VkPhysicalDeviceProperties physical_device_properties;
-
-    uint32_t extensionPropertiesCount;
-    std::vector<VkExtensionProperties> deviceExtensionsProperties;
-
-    VkPhysicalDeviceFeatures physicalDeviceFeatures = {0u};
-    physicalDeviceFeatures.depthClamp = VK_TRUE;
-
-    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-
-    vkEnumeratePhysicalDevices(m_instance, &device_count, nullptr);
-
-    m_available_devices.resize(device_count);
-
-    vkEnumeratePhysicalDevices(m_instance, &device_count, &m_available_devices[0]);
-
-    /* select best device (now only based on type) */
-    for (const auto& physical_device : m_available_devices)
-    {
-        vkGetPhysicalDeviceProperties(physical_device, &physical_device_properties);
-        std::cout << physical_device_properties.deviceName << std::endl;
-        std::cout << physical_device_properties.deviceType << std::endl;
-    }
-
-    if (device_count > 1u)
-    {
-        m_selected_device = best_device;
-    }
-    else
-    {
-        m_selected_device = best_device;
-    }
-
-    vkEnumerateDeviceExtensionProperties(m_available_devices[m_selected_device], nullptr, &extensionPropertiesCount, nullptr);
-    deviceExtensionsProperties.resize(extensionPropertiesCount);
-
-    vkEnumerateDeviceExtensionProperties(m_available_devices[m_selected_device], nullptr, &extensionPropertiesCount, &deviceExtensionsProperties[0]);
-
-    for (const auto & property : deviceExtensionsProperties)
-    {
-        std::cout << property.extensionName << ", version: " << property.specVersion << std::endl;
-    }
-
-    std::cout << "Getting queue family properties:" << std::endl;
-    vkGetPhysicalDeviceQueueFamilyProperties(m_available_devices[m_selected_device], &queue_count, nullptr);
-
-    std::cout << "Number of queues: " << queue_count << std::endl;
-    queue_family_properties.resize(queue_count);
-
-    vkGetPhysicalDeviceQueueFamilyProperties(m_available_devices[m_selected_device], &queue_count, &queue_family_properties[0]);
-
-    
-
-    /* select queue with graphics and present capabilities */
-    uint8_t i = 0u;
-    VkBool32 presentSupport;
-    for (const auto& queue : queue_family_properties)
-    {
-        std::cout << "Flags: " << queue.queueFlags << std::endl;
-        std::cout << "Queue count: " << queue.queueCount << std::endl << std::endl;
-
-        if (0u != (queue.queueFlags & VK_QUEUE_GRAPHICS_BIT))
-        {
-            m_graphics_queue_idx = i;
-        }
-
-        vkGetPhysicalDeviceSurfaceSupportKHR(m_available_devices[m_selected_device], i, m_surface, &presentSupport);
-        if (VK_TRUE == presentSupport)
-        {
-            m_present_queue_idx = i;
-        }
-
-        i++;
-    }
-
-    float queuePriorities[2u] = {1.f, 1.f};
-    VkDeviceQueueCreateInfo qci =
-        {
-            .sType              = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-            .pNext              = nullptr,
-            .flags              = 0u,
-            .queueFamilyIndex   = m_graphics_queue_idx,
-            .queueCount         = 1u,
-            .pQueuePriorities   = queuePriorities,
-        };
-
-    queueCreateInfos.push_back(qci);
-
-    if (m_graphics_queue_idx != m_present_queue_idx)
-    {
-        qci.queueCount = 2u,
-        qci.queueFamilyIndex = m_present_queue_idx;
-        queueCreateInfos.push_back(qci);
-    }
-
-    VkDeviceCreateInfo dci = 
-    {
-        .sType                      = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext                      = nullptr,
-        .flags                      = 0,
-        .queueCreateInfoCount       = (uint32_t) queueCreateInfos.size(),
-        .pQueueCreateInfos          = &queueCreateInfos[0],
-        .enabledLayerCount          = 0u,
-        .ppEnabledLayerNames        = nullptr,
-        .enabledExtensionCount      = (uint32_t) m_requiredPhysicalDeviceExtension.size(),
-        .ppEnabledExtensionNames    = &m_requiredPhysicalDeviceExtension[0u],
-        .pEnabledFeatures           = &physicalDeviceFeatures,
-    };
-
-    result = vkCreateDevice(m_available_devices[0], &dci, nullptr, &m_device);
-    printResult(result, "Device creation result");
-}
-
-uint32_t Example::getQueueFamilyIndex()
-{
-    /* TODO update logic */
-    return 0u;
-}
-
-void Example::createSwapchain(void)
-{
-    VkResult result;
-
-    result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_available_devices[m_selected_device], m_surface, &m_surfaceCapabilities);
-    printResult(result, "Request for surface capabilities result");
-
-
-    uint32_t presentModeCount;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(m_available_devices[m_selected_device], m_surface, &presentModeCount, nullptr);
-
-    m_presentModes.resize(presentModeCount);
-    result = vkGetPhysicalDeviceSurfacePresentModesKHR(m_available_devices[m_selected_device], m_surface, &presentModeCount, &m_presentModes[0u]);
-    printResult(result, "Request for surface present modes result");
-
-    uint32_t formatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(m_available_devices[m_selected_device], m_surface, &formatCount, nullptr);
-
-    m_surfaceFormats.resize(formatCount);
-    result = vkGetPhysicalDeviceSurfaceFormatsKHR(m_available_devices[m_selected_device], m_surface, &formatCount, &m_surfaceFormats[0u]);
-    printResult(result, "Request for surface formats result");
-
-    uint32_t imageCount = m_surfaceCapabilities.minImageCount;
-    if ((m_surfaceCapabilities.maxImageCount > 1u) || (m_surfaceCapabilities.maxImageCount == 0u))
-    {
-        m_isDoubleBufferingSupported = VK_TRUE;
-        m_selectedBufferingMode = DOUBLE_BUFFERING;
-    }
-
-    if ((m_surfaceCapabilities.maxImageCount > 2u) || (m_surfaceCapabilities.maxImageCount == 0u))
-    {
-        m_isTrippleBufferingSupported = VK_TRUE;
-        //m_selectedBufferingMode = TRIPPLE_BUFFERING;
-    }
-
-    if (TRIPPLE_BUFFERING == m_selectedBufferingMode)
-    {
-        if (3u > imageCount) imageCount = 3u;
-    }
-    else if (DOUBLE_BUFFERING == m_selectedBufferingMode)
-    {
-        if (2u > imageCount) imageCount = 2u;
-    }
-    else
-    {
-        /* Neither Double buffering nor tripple buffering supported, handle error */
-    }
-
-    uint32_t queueFamilyIndices[1u] = {m_graphics_queue_idx};
-
-    VkSwapchainCreateInfoKHR sci = 
-    {
-        .sType                  = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-        .pNext                  = nullptr,
-        .flags                  = 0,
-        .surface                = m_surface,
-        .minImageCount          = imageCount,
-        .imageFormat            = m_surfaceFormats[3u].format,
-        .imageColorSpace        = m_surfaceFormats[3u].colorSpace,
-        .imageExtent            = m_surfaceCapabilities.currentExtent,
-        .imageArrayLayers       = 1u,
-        .imageUsage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-        .imageSharingMode       = (m_graphics_queue_idx == m_present_queue_idx) ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT,
-        .queueFamilyIndexCount  = 1u,
-        .pQueueFamilyIndices    = queueFamilyIndices,
-        .preTransform           = m_surfaceCapabilities.currentTransform,
-        .compositeAlpha         = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-        .presentMode            = VK_PRESENT_MODE_FIFO_KHR,
-        .clipped                = VK_TRUE,
-        .oldSwapchain           = VK_NULL_HANDLE,
-    };
-
-    result = vkCreateSwapchainKHR(m_device, &sci, nullptr, &m_swapchain);
-    printResult(result, "Swapchain creation result");
-
-    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, nullptr);
-    m_swapchainImages.resize(imageCount);
-    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, &m_swapchainImages[0u]);
-}
-
-void Example::createImageViews(void)
-{
-    VkResult result;
-    m_swapchainImageViews.resize(m_swapchainImages.size());
-    
-    VkImageViewCreateInfo ivci = 
-    {
-        .sType              = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-        .pNext              = nullptr,
-        .flags              = 0,
-        .viewType           = VK_IMAGE_VIEW_TYPE_2D,
-        .format             = m_surfaceFormats[3u].format,
-        .components         = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
-        .subresourceRange   = {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u},
-    };
-
-    for (uint32_t i = 0u; i < m_swapchainImages.size(); i++)
-    {
-        ivci.image = m_swapchainImages[i];
-        result = vkCreateImageView(m_device, &ivci, nullptr, &m_swapchainImageViews[i]);
-        printResult(result, "Image view creation result");
-    }
-}
-
-void Example::createDepthResources(void)
-{
-    VkResult result;
-    
-    /* TODO Which format is the best? How to guarantee functionality */
-    VkFormatProperties formatProperties;
-    vkGetPhysicalDeviceFormatProperties(m_available_devices[m_selected_device], VK_FORMAT_D32_SFLOAT, &formatProperties);
-
-    std::cout << std::hex << formatProperties.optimalTilingFeatures << std::endl;
-    std::cout << std::hex << formatProperties.linearTilingFeatures  << std::endl;
-
-    VkImageCreateInfo imageInfo =
-    {
-        .sType                  = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-        .pNext                  = nullptr,
-        .flags                  = 0,
-        .imageType              = VK_IMAGE_TYPE_2D,
-        .format                 = VK_FORMAT_D32_SFLOAT,
-        .extent                 = {640, 480, 1},
-        .mipLevels              = 1u,
-        .arrayLayers            = 1u,
-        .samples                = VK_SAMPLE_COUNT_1_BIT,
-        .tiling                 = VK_IMAGE_TILING_OPTIMAL,
-        .usage                  = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-        .sharingMode            = VK_SHARING_MODE_EXCLUSIVE,
-        .initialLayout          = VK_IMAGE_LAYOUT_UNDEFINED,
-    };
-
-    result = vkCreateImage(m_device, &imageInfo, nullptr, &m_depthImage);
-    printResult(result, "Depth image creation result");
-
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(m_device, m_depthImage, &memRequirements);
-
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(m_available_devices[m_selected_device], &memProperties);
-
-    VkMemoryAllocateInfo mai = 
-    {
-        .sType              = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext              = nullptr,
-        .allocationSize     = memRequirements.size,
-        .memoryTypeIndex    = 0u,
-    };
-
-    vkAllocateMemory(m_device, &mai, nullptr, &m_depthImageMemory);
-    vkBindImageMemory(m_device, m_depthImage, m_depthImageMemory, 0u);
-    VkImageViewCreateInfo ivci =
-    {
-        .sType              = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-        .pNext              = nullptr,
-        .flags              = 0,
-        .image              = m_depthImage,
-        .viewType           = VK_IMAGE_VIEW_TYPE_2D,
-        .format             = VK_FORMAT_D32_SFLOAT,
-        .components         = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
-        .subresourceRange   = {VK_IMAGE_ASPECT_DEPTH_BIT, 0u, 1u, 0u, 1u},
-    };
-    result = vkCreateImageView(m_device, &ivci, nullptr, &m_depthImageView);
-    printResult(result, "Depth buffer image view creation result");
-}
-
-void Example::createRenderPass(void)
-{
-    VkResult result;
-    VkAttachmentDescription attachment_descriptions[] = 
-    {
-        /* Color attachment */
-        {
-            .flags          = 0,
-            .format         = VK_FORMAT_R8G8B8A8_SRGB,
-            .samples        = VK_SAMPLE_COUNT_1_BIT,
-            .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .storeOp        = VK_ATTACHMENT_STORE_OP_STORE,
-            .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-            .finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        },
-        /* Depth attachment */
-        {
-            .flags          = 0,
-            .format         = VK_FORMAT_D32_SFLOAT,
-            .samples        = VK_SAMPLE_COUNT_1_BIT,
-            .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
-            .storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
-            .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-            .finalLayout    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-        }
-    };
-
-    VkAttachmentReference color_attachment_references[] = 
-    {
-        {
-            .attachment = 0u,
-            .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        }
-    };
-
-    VkAttachmentReference depth_attachment_references[] =
-    {
-        {
-            .attachment = 1u,
-            .layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-        }
-    };
-
-    VkSubpassDescription sds[] = 
-    {
-        {
-            .flags                      = 0,
-            .pipelineBindPoint          = VK_PIPELINE_BIND_POINT_GRAPHICS,
-            .inputAttachmentCount       = 0u,
-            .pInputAttachments          = nullptr,
-            .colorAttachmentCount       = 1u,
-            .pColorAttachments          = color_attachment_references,
-            .pResolveAttachments        = nullptr,
-            .pDepthStencilAttachment    = depth_attachment_references,
-            .preserveAttachmentCount    = 0u,
-            .pPreserveAttachments       = nullptr,
-        }
-    };
-
-    VkRenderPassCreateInfo rpci = 
-    {
-        .sType              = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-        .pNext              = nullptr,
-        .flags              = 0,
-        .attachmentCount    = 2u,
-        .pAttachments       = attachment_descriptions,
-        .subpassCount       = 1u,
-        .pSubpasses         = sds,
-        .dependencyCount    = 0u,
-        .pDependencies      = nullptr,
-    };
-
-    result = vkCreateRenderPass(m_device, &rpci, nullptr, &m_renderPass);
-    printResult(result, "Renderpass creation result");
-}
-
-void Example::createFramebuffers(void)
-{
-    VkResult result;
-    VkFramebufferCreateInfo fci =
-    {
-        .sType              = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-        .pNext              = nullptr,
-        .flags              = 0,
-        .renderPass         = m_renderPass,
-        .attachmentCount    = 2u,
-        .pAttachments       = nullptr,
-        .width              = m_surfaceCapabilities.currentExtent.width,
-        .height             = m_surfaceCapabilities.currentExtent.height,
-        .layers             = 1u,
-    };
-
-    m_framebuffers.resize(m_swapchainImageViews.size());
-
-    for (uint8_t i = 0; i < m_swapchainImageViews.size(); i++)
-    {
-        VkImageView attachments[] = {m_swapchainImageViews[i], m_depthImageView};
-        fci.pAttachments = attachments;
-
-        result = vkCreateFramebuffer(m_device, &fci, nullptr, &m_framebuffers[i]);
-        printResult(result, "Framebuffer creation result");
-    }
-}
-
-std::vector<char> readFile(const std::string & pathToShader)
-{
-    std::ifstream file(pathToShader, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open())
-    {
-        throw std::runtime_error("Unable to open file!");
-    }
-
-    size_t fileSize = (size_t) file.tellg();
-    std::vector<char> buffer(fileSize);
-
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-
-    return buffer;
-}
-
-void Example::createPipeline(void)
-{
-    /*
-    vkCreatePipelineLayout -> VkPipelineLayout
-    |-> VkPipelineLayoutCreateInfo
-        |-> VkDescriptorSetLayout
-
-    vkCreateDescriptorSetLayout -> VkDescriptorSetLayout
-    |-> VkDescriptorSetLayoutCreateInfo
-        |-> VkDescriptorSetLayoutBindings
-    
-    vkAllocateDescriptorSets -> VkDescriptorSet
-    |-> VkDescriptorSetAllocateInfo
-        |-> VkDescriptorSetLayout
-    */
-    /* Get memory requirements for model */
-    VkResult result;
-    uint32_t queueFamilyIndices = {0};
-    VkBufferCreateInfo bci = 
-    {
-        .sType                  = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .pNext                  = nullptr,
-        .flags                  = 0,
-        .size                   = sizeof(my_cube),
-        .usage                  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        .sharingMode            = VK_SHARING_MODE_EXCLUSIVE,
-        .queueFamilyIndexCount  = 1,
-        .pQueueFamilyIndices    = &queueFamilyIndices,
-    };
-    result = vkCreateBuffer(m_device, &bci, nullptr, &m_modelBuffer);
-    printResult(result, "Buffer creation result");
-
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(m_device, m_modelBuffer, &memoryRequirements);
-
-    VkMemoryAllocateInfo mai = 
-    {
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = nullptr,
-        .allocationSize = memoryRequirements.size,
-        .memoryTypeIndex = 0,
-    };
-    result = vkAllocateMemory(m_device, &mai, nullptr, &m_modelBufferMemory);
-    printResult(result, "Memory allocation for buffer result");
-
-    result = vkBindBufferMemory(m_device, m_modelBuffer, m_modelBufferMemory, 0u);
-    printResult(result, "Binding memory result");
-
-    /* Load model data into memory */
-    void * data;
-    result = vkMapMemory(m_device, m_modelBufferMemory, 0, memoryRequirements.size, 0, &data);
-    printResult(result, "Mapping memory result");
-
-    memcpy(data, &my_cube[0], bci.size);
-    vkUnmapMemory(m_device, m_modelBufferMemory);
-
-
-    VkPipelineInputAssemblyStateCreateInfo piasci = 
-    {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-        .primitiveRestartEnable = VK_FALSE, /* TODO ask about restart enable, how does it work? */
-    };
-
-    VkVertexInputBindingDescription vibds[] =
-    {
-        {
-            .binding = 0u,
-            .stride = sizeof(struct Vertex),   /* size of vertex */
-            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
-        }
-    };
-
-    VkVertexInputAttributeDescription viads[] = 
-    {
-        { .location = 0u, .binding = 0u, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(Vertex, coord)},
-        { .location = 1u, .binding = 0u, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(Vertex, color)}
-    };
-
-    VkPipelineVertexInputStateCreateInfo pvisci = 
-    {
-        .sType                              = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .pNext                              = nullptr,
-        .flags                              = 0,
-        .vertexBindingDescriptionCount      = sizeof(vibds) / sizeof(vibds[0]),
-        .pVertexBindingDescriptions         = vibds,
-        .vertexAttributeDescriptionCount    = sizeof(viads) / sizeof(viads[0]),
-        .pVertexAttributeDescriptions       = viads,
-    };
-
-    std::vector<char> vertexShaderCode = readFile("./shaders/vert.spv");
-    std::vector<char> fragmentShaderCode = readFile("./shaders/frag.spv");
-
-    VkShaderModuleCreateInfo vertexShaderCreateInfo =
-    {
-        .sType      = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .pNext      = nullptr,
-        .flags      = 0,
-        .codeSize   = vertexShaderCode.size(),
-        .pCode      = reinterpret_cast<const uint32_t *>(vertexShaderCode.data()),
-    };
-
-    VkShaderModule vertexShaderModule;
-    result = vkCreateShaderModule(m_device, &vertexShaderCreateInfo, nullptr, &vertexShaderModule);
-    printResult(result, "Vertex shader module module creation status");
-    
-    VkViewport vp[] = 
-    {
-        {.x = 0.0f, .y = 0.0f, .width = 640.0f, .height = 480.0f, .minDepth = 0.f, .maxDepth = 1.f}
-    };
-
-    VkRect2D scissors[] = 
-    {
-        {.offset = {0, 0}, .extent = {640u, 480u}}
-    };
-
-    VkPipelineViewportStateCreateInfo pvsci = 
-    {
-        .sType          = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .pNext          = nullptr,
-        .flags          = 0,
-        .viewportCount  = 1u,
-        .pViewports     = vp,
-        .scissorCount   = 1u,
-        .pScissors      = scissors,
-    };
-
-    VkPipelineRasterizationStateCreateInfo prsci = 
-    {
-        .sType                      = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .pNext                      = nullptr,
-        .flags                      = 0,
-        .depthClampEnable           = VK_FALSE,//VK_TRUE,
-        .rasterizerDiscardEnable    = VK_FALSE,//VK_TRUE,
-        .polygonMode                = VK_POLYGON_MODE_FILL,
-        .cullMode                   = VK_CULL_MODE_BACK_BIT,
-        .frontFace                  = VK_FRONT_FACE_CLOCKWISE,
-        .depthBiasEnable            = VK_FALSE,
-        .depthBiasConstantFactor    = 0.0f,
-        .depthBiasClamp             = 0.0f,
-        .depthBiasSlopeFactor       = 0.0f,
-        .lineWidth                  = 1.0f,
-    };
-
-    VkShaderModuleCreateInfo fragmentShaderCreateInfo =
-    {
-        .sType      = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .pNext      = nullptr,
-        .flags      = 0,
-        .codeSize   = fragmentShaderCode.size(),
-        .pCode      = reinterpret_cast<const uint32_t *>(fragmentShaderCode.data()),
-    };
-
-    VkShaderModule fragmentShaderModule;
-    result = vkCreateShaderModule(m_device, &fragmentShaderCreateInfo, nullptr, &fragmentShaderModule);
-    printResult(result, "Fragment shader module creation result");
-
-    VkPipelineShaderStageCreateInfo shaderStagesInfo[] = 
-    {
-        {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .stage = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = vertexShaderModule,
-            .pName = "main",
-            .pSpecializationInfo = nullptr,
-        },
-        {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = fragmentShaderModule,
-            .pName = "main",
-            .pSpecializationInfo = nullptr,
-        }
-    };
-
-    /* TODO pipeline layout??? */
-    VkPipelineLayoutCreateInfo plci = 
-    {
-        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .pNext                  = nullptr,
-        .flags                  = 0,
-        .setLayoutCount         = 0u,
-        .pSetLayouts            = nullptr,
-        .pushConstantRangeCount = 0u,
-        .pPushConstantRanges    = nullptr,
-    };
-
-    result = vkCreatePipelineLayout(m_device, &plci, nullptr, &m_pipelineLayout);
-    printResult(result, "Pipeline layout creation result");
-
-    /* Test */
-    VkPipelineMultisampleStateCreateInfo pmssci = 
-    {
-        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .pNext                  = nullptr,
-        .flags                  = 0,
-        .rasterizationSamples   = VK_SAMPLE_COUNT_1_BIT,
-        .sampleShadingEnable    = VK_FALSE,
-        .minSampleShading       = 1.f,
-        .pSampleMask            = nullptr,
-        .alphaToCoverageEnable  = VK_FALSE,
-        .alphaToOneEnable       = VK_FALSE,
-    };
-
-    VkPipelineDepthStencilStateCreateInfo pdssci = 
-    {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-    };
-
-    VkPipelineColorBlendAttachmentState pcbas = 
-    {
-        .blendEnable = VK_FALSE,
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-    };
-
-    VkPipelineColorBlendStateCreateInfo pcbsci = 
-    {
-        .sType              = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .pNext              = nullptr,
-        .flags              = 0,
-        .logicOpEnable      = VK_FALSE,
-        .logicOp            = VK_LOGIC_OP_CLEAR,
-        .attachmentCount    = 1,
-        .pAttachments       = &pcbas,
-        .blendConstants     = {0.f, 0.f, 0.f, 0.f},
-    };
-
-    VkGraphicsPipelineCreateInfo ci =
-    {
-        .sType                  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-        .pNext                  = nullptr,
-        .flags                  = 0,
-        .stageCount             = 2u,
-        .pStages                = shaderStagesInfo,
-        .pVertexInputState      = &pvisci,
-        .pInputAssemblyState    = &piasci,
-        .pTessellationState     = nullptr,
-        .pViewportState         = &pvsci,
-        .pRasterizationState    = &prsci,
-        .pMultisampleState      = &pmssci,
-        .pDepthStencilState     = &pdssci,
-        .pColorBlendState       = &pcbsci,
-        .pDynamicState          = nullptr,
-        .layout                 = m_pipelineLayout,
-        .renderPass             = m_renderPass,
-        .subpass                = 0u,
-        .basePipelineHandle     = VK_NULL_HANDLE,
-        .basePipelineIndex      = -1,
-    };
-
-    m_pipelines.resize(1u);
-    result = vkCreateGraphicsPipelines(m_device,
-                                       VK_NULL_HANDLE,
-                                       1,
-                                       &ci,
-                                       nullptr,
-                                       &m_pipelines[0]);
-    printResult(result, "Graphics pipeline creation result");
-
-    vkDestroyShaderModule(m_device, vertexShaderModule, nullptr);
-    vkDestroyShaderModule(m_device, fragmentShaderModule, nullptr);
-}
-
-void Example::createCommandBuffers(void)
-{
-    VkResult result;
-
-    VkCommandPoolCreateInfo cpci = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-        .pNext = NULL,
-        .flags = 0,
-        .queueFamilyIndex = 0u,
-    };
-
-    result = vkCreateCommandPool(m_device, &cpci, NULL, &m_commandPool);
-    printResult(result, "Command pool creation result");
-
-    m_commandBuffers.resize(m_framebuffers.size());
-
-    VkCommandBufferAllocateInfo cbai = {
-        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .pNext              = NULL,
-        .commandPool        = m_commandPool,
-        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = (uint32_t) m_commandBuffers.size(),
-    };
-    result = vkAllocateCommandBuffers(m_device, &cbai, m_commandBuffers.data());
-    printResult(result, "Command buffer allocation result");
-
-    VkCommandBufferBeginInfo cbbi = {
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-        .pNext = NULL,
-        .flags = 0,
-        .pInheritanceInfo = NULL,
-    };
-
-    VkClearValue clearValues[] = {0.f, 0.f};
-    VkRenderPassBeginInfo rpbi = {
-        .sType          = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-        .pNext          = NULL,
-        .renderPass     = m_renderPass,
-        .framebuffer    = m_framebuffers[m_submissionNumber],
-        .renderArea     = {{0, 0}, {640u, 480u}},
-        .clearValueCount = 2u,
-        .pClearValues   = clearValues,
-    };
-
-    VkDeviceSize offsets[] = {0u};
-    for (uint8_t i = 0u; i < m_commandBuffers.size(); i++)
-    {
-        result = vkBeginCommandBuffer(m_commandBuffers[i], &cbbi);
-        rpbi.framebuffer = m_framebuffers[i];
-
-        vkCmdBeginRenderPass(m_commandBuffers[i], &rpbi, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[0u]);
-        vkCmdBindVertexBuffers(m_commandBuffers[i], 0, 1, &m_modelBuffer, offsets);
-        uint32_t vertexCount = sizeof(my_cube) / sizeof(my_cube[0]);
-        vkCmdDraw(m_commandBuffers[i], vertexCount, 1u, 0u, 0u);
-
-        vkCmdEndRenderPass(m_commandBuffers[i]);
-        result = vkEndCommandBuffer(m_commandBuffers[i]);
-    }
-}
-
-void Example::createSemaphores(void)
-{
-    VkSemaphoreCreateInfo sci =
-    {
-        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-    };
-    
-    m_imageReadySemaphores.resize(m_swapchainImages.size());
-    for (uint32_t i = 0u; i < m_swapchainImages.size(); i++)
-    {
-        vkCreateSemaphore(m_device, &sci, nullptr, &m_imageReadySemaphores[i]);
-    }
-
-    vkCreateSemaphore(m_device, &sci, nullptr, &m_renderDoneSemaphore);
-}
-
-void Example::createFences(void)
-{
-    VkFenceCreateInfo fci = 
-    {
-        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
-    };
-
-    m_drawFences.resize(m_maxInflightSubmissions);
-    for (uint32_t i = 0u; i < m_maxInflightSubmissions; i++)
-    {
-        vkCreateFence(m_device, &fci, nullptr, &m_drawFences[i]);
-    }
-}
-
-void Example::drawFrame(void)
-{
-    VkResult result;
-    uint32_t nextImageIndex;
-    VkPresentInfoKHR presentInfo;
-
-    vkWaitForFences(m_device, 1, &m_drawFences[m_submissionNumber], VK_TRUE, UINT64_MAX);
-    vkResetFences(m_device, 1, &m_drawFences[m_submissionNumber]);
-
-    result = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_imageReadySemaphores[m_submissionNumber], VK_NULL_HANDLE, &nextImageIndex);
-
-    VkPipelineStageFlags pipelineStageFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-    /* Use sync primitive so we don't modify image being read from */
-    if (VK_SUCCESS == result)
-    {
-        /* Queue all rendering commands and transition the image layout  */
-        VkSubmitInfo submitInfo = {
-            .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .pNext              = NULL,
-            .waitSemaphoreCount = 1u,
-            .pWaitSemaphores    = &m_imageReadySemaphores[m_submissionNumber],
-            .pWaitDstStageMask  = &pipelineStageFlags,
-            .commandBufferCount = 1u,
-            .pCommandBuffers    = &m_commandBuffers[nextImageIndex],
-            .signalSemaphoreCount = 1u,
-            .pSignalSemaphores  = &m_renderDoneSemaphore,
-        };
-        VkQueue graphicsQueue;
-        vkGetDeviceQueue(m_device, 0u, m_graphics_queue_idx, &graphicsQueue);
-        vkQueueSubmit(graphicsQueue, 1u, &submitInfo, m_drawFences[m_submissionNumber]);
-
-        m_submissionNumber = (m_submissionNumber + 1u) % m_maxInflightSubmissions;
-
-        /* Queue the image for presentation */
-        presentInfo.sType               = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        presentInfo.pNext               = NULL;
-        presentInfo.waitSemaphoreCount  = 1u;
-        presentInfo.pWaitSemaphores     = &m_renderDoneSemaphore;
-        presentInfo.swapchainCount      = 1u;
-        presentInfo.pSwapchains         = &m_swapchain;
-        presentInfo.pImageIndices       = &nextImageIndex;
-        presentInfo.pResults            = NULL;
-
-        VkQueue presentQueue;
-        vkGetDeviceQueue(m_device, 0u, m_present_queue_idx, &presentQueue);
-        result = vkQueuePresentKHR(presentQueue, &presentInfo);
-        //printResult(result, "Presenting image result");
-    }
-}
-
-void Example::cleanup(void)
-{
-    /* Command pool may be freed only after all command buffers are in pending???/init state??? */
-    //vkDestroyCommandPool(m_device, m_commandPool, NULL);
-    vkDestroyBuffer(m_device, m_modelBuffer, nullptr);
-    vkFreeMemory(m_device, m_modelBufferMemory, nullptr);
-
-    vkDestroyImageView(m_device, m_depthImageView, nullptr);
-    vkDestroyImage(m_device, m_depthImage, nullptr);
-    vkFreeMemory(m_device, m_depthImageMemory, nullptr);
-    for (auto & framebuffer : m_framebuffers)
-    {
-        vkDestroyFramebuffer(m_device, framebuffer, nullptr);
-    }
-    vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
-    for (auto imageView : m_swapchainImageViews)
-    {
-        vkDestroyImageView(m_device, imageView, nullptr);
-    }
-    for (auto & pipeline : m_pipelines)
-    {
-        vkDestroyPipeline(m_device, pipeline, nullptr);
-    }
-    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-    vkDestroyRenderPass(m_device, m_renderPass, nullptr);
-    vkDestroyDevice(m_device, nullptr);
-    vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
-    glfwDestroyWindow(m_window);
-    glfwTerminate();
-    vkDestroyInstance(m_instance, nullptr);
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include "example.hpp"
+#include "mesh.hpp"
+#include "embedded_shaders.hpp"
+
+#include "glm/glm/vec3.hpp"
+#include "glm/glm/gtc/matrix_transform.hpp"
+
+/* Mesh file sections are copied into staging memory in pieces of this size */
+#define MESH_UPLOAD_CHUNK_SIZE  (16ull * 1024ull * 1024ull)
+
+#if defined USE_GLM
+Vertex my_cube[] =
+{
+    /* front side - red */
+    {VERTEX_1, COLOR_RED}, {VERTEX_4, COLOR_RED}, {VERTEX_3, COLOR_RED},
+    {VERTEX_1, COLOR_RED}, {VERTEX_3, COLOR_RED}, {VERTEX_2, COLOR_RED},
+    
+    #if 1
+    /* right side - green */
+    {VERTEX_2, COLOR_GREEN}, {VERTEX_3, COLOR_GREEN}, {VERTEX_7, COLOR_GREEN},
+    {VERTEX_2, COLOR_GREEN}, {VERTEX_7, COLOR_GREEN}, {VERTEX_6, COLOR_GREEN},
+    
+    /* left side - blue */
+    {VERTEX_5, COLOR_BLUE}, {VERTEX_8, COLOR_BLUE}, {VERTEX_4, COLOR_BLUE},
+    {VERTEX_5, COLOR_BLUE}, {VERTEX_4, COLOR_BLUE}, {VERTEX_1, COLOR_BLUE},
+
+    /* top side - yellow */
+    {VERTEX_4, COLOR_RG}, {VERTEX_8, COLOR_RG}, {VERTEX_7, COLOR_RG},
+    {VERTEX_4, COLOR_RG}, {VERTEX_7, COLOR_RG}, {VERTEX_3, COLOR_RG},
+    
+    /* bottom side - magenta */
+    {VERTEX_5, COLOR_RB}, {VERTEX_1, COLOR_RB}, {VERTEX_2, COLOR_RB},
+    {VERTEX_5, COLOR_RB}, {VERTEX_2, COLOR_RB}, {VERTEX_6, COLOR_RB},
+
+    /* back side - cyan */
+    {VERTEX_7, COLOR_GB}, {VERTEX_8, COLOR_GB}, {VERTEX_6, COLOR_GB},
+    {VERTEX_6, COLOR_GB}, {VERTEX_8, COLOR_GB}, {VERTEX_5, COLOR_GB},
+    #endif
+};
+#endif
+
+uint32_t Example::getCubeSizeBytes(void)
+{
+    return sizeof(my_cube);
+}
+
+uint32_t Example::getCubeVerticesCount(void)
+{
+    return sizeof(my_cube) / sizeof(my_cube[0]);
+}
+
+static glm::mat4 camera(float Translate, glm::vec2 const &Rotate, float aspect)
+{
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(1.0f, 1.0f, -50.0f));
+    model = glm::scale(model, glm::vec3(10.0f, 10.0f, 10.0f));
+    model = glm::rotate(model, (float)(glm::radians(45.0f + Rotate.x)), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, (float)(glm::radians(15.0f + Rotate.y)), glm::vec3(1.0f, 0.0f, 0.0f));
+
+    glm::mat4 view = glm::mat4(1.0f);
+    view = glm::translate(view, glm::vec3(-0.5f, -0.5f, 100.f + Translate));
+
+    glm::mat4 projection = glm::scale(glm::perspective(45.0f, aspect, 0.1f, 1000.0f), glm::vec3(1.0f, 1.0f, -1.0f));
+
+    //glm::mat4 projection = glm::ortho(0.0f, 640.0f, 0.0f, 480.0f, 0.1f, 100.0f);
+    return projection * view * model; 
+}
+
+static void printResult(VkResult result, std::string message)
+{
+    switch (result)
+    {
+    case VK_SUCCESS:
+        std::cout << message + ":[0] VK_SUCCESS"<< std::endl;
+        break;
+    case VK_ERROR_EXTENSION_NOT_PRESENT:
+        std::cout << message + ":[-7] VK_ERROR_EXTENSION_NOT_PRESENT" << std::endl;
+        break;
+    default:
+        std::cout << result << std::endl;
+        break;
+    }
+}
+
+int32_t Example::createWindow(void)
+{
+    VkResult result;
+
+    if (!glfwInit())
+        return -1;
+    
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    m_window = glfwCreateWindow((int) m_extent.width, (int) m_extent.height, "Hello World", NULL, NULL);
+
+    if (!m_window)
+    {
+        std::cout << "Window creation failed!" << std::endl;
+        return -1;
+    }
+
+    /* Resizes are only flagged here, the swapchain is recreated by the next drawFrame() */
+    glfwSetWindowUserPointer(m_window, this);
+    glfwSetFramebufferSizeCallback(m_window, [](GLFWwindow * window, int width, int height)
+    {
+        (void) width;
+        (void) height;
+        static_cast<Example *>(glfwGetWindowUserPointer(window))->invalidateSwapchain();
+    });
+    
+    result = glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface);
+    printResult(result, "Surface creation result");
+
+    return 0;
+}
+
+void Example::run(void)
+{
+    while (!glfwWindowShouldClose(m_window))
+    {
+        glfwPollEvents();
+
+        /* A minimized window has no extent and no swapchain can be created for it, sleep until it is restored */
+        int width, height;
+        glfwGetFramebufferSize(m_window, &width, &height);
+        if ((0 == width) || (0 == height))
+        {
+            glfwWaitEvents();
+            continue;
+        }
+
+        drawFrame();
+    }
+    vkDeviceWaitIdle(m_device);
+
+    printRecordingStatistics();
+    finishProfiling();
+}
+
+void Example::setDevicePreference(const std::string & preference)
+{
+    m_devicePreference = preference;
+}
+
+void Example::setHeadless(VkBool32 headless)
+{
+    m_headless = headless;
+
+    if (VK_TRUE == m_headless)
+    {
+        /* No surface and no swapchain, so neither WSI extension is needed */
+        m_required_instance_extensions.clear();
+        m_requiredPhysicalDeviceExtension.clear();
+    }
+}
+
+void Example::buildInitGraph(TaskGraph & graph)
+{
+    /*
+     * Every create* step with the steps it really needs. Shader loading runs alongside instance and
+     * device creation, pipeline compilation and mesh upload alongside swapchain, depth and framebuffer creation.
+     */
+    uint32_t shaders        = graph.addTask("loadShaders", [this] { loadShaders(); });
+    uint32_t instance       = graph.addTask("createInstance", [this] { createInstance(); });
+    uint32_t device;
+    uint32_t targets;
+
+    if (VK_TRUE == m_headless)
+    {
+        device              = graph.addTask("createDevice", [this] { createDevice(); }, {instance});
+        targets             = graph.addTask("createOffscreenTargets", [this] { createOffscreenTargets(); }, {device});
+    }
+    else
+    {
+        /* GLFW may only be used from the main thread */
+        uint32_t window     = graph.addTask("createWindow", [this] { createWindow(); }, {instance}, true);
+        device              = graph.addTask("createDevice", [this] { createDevice(); }, {window});
+        targets             = graph.addTask("createSwapchain", [this] { createSwapchain(); }, {device});
+    }
+
+    uint32_t imageViews     = graph.addTask("createImageViews", [this] { createImageViews(); }, {targets});
+    uint32_t frameGraph     = graph.addTask("createFrameGraph", [this] { createFrameGraph(); }, {targets});
+    uint32_t renderPass     = graph.addTask("createRenderPass", [this] { createRenderPass(); }, {frameGraph});
+    uint32_t uploader       = graph.addTask("createUploadService", [this] { createUploadService(); }, {device});
+    uint32_t pipelineCache  = graph.addTask("createPipelineCache", [this] { createPipelineCache(); }, {device});
+    uint32_t meshBuffers    = graph.addTask("createMeshBuffers", [this] { createMeshBuffers(); }, {uploader});
+    uint32_t pipeline       = graph.addTask("createPipeline", [this] { createPipeline(); }, {shaders, renderPass, pipelineCache});
+    uint32_t framebuffers   = graph.addTask("createFramebuffers", [this] { createFramebuffers(); }, {imageViews, frameGraph, renderPass});
+    uint32_t uniforms       = graph.addTask("createUniformBuffers", [this] { createUniformBuffers(); }, {targets, pipeline});
+    uint32_t instances      = graph.addTask("createInstanceBuffers", [this] { createInstanceBuffers(); }, {targets});
+
+    std::vector<uint32_t> recordingInputs = {framebuffers, uniforms, instances, meshBuffers, pipeline};
+    if (VK_TRUE == m_gpuCulling)
+    {
+        /* The bounding sphere comes from the mesh, the source instances from the instance buffers */
+        uint32_t cullPipeline = graph.addTask("createCullingPipeline", [this] { createCullingPipeline(); }, {shaders, pipelineCache});
+        recordingInputs.push_back(graph.addTask("createCullingBuffers", [this] { createCullingBuffers(); }, {instances, cullPipeline}));
+    }
+
+    /* Frames in flight are final once the swapchain exists */
+    graph.addTask("createCommandBuffers", [this] { createCommandBuffers(); }, recordingInputs);
+    if (VK_FALSE == m_headless)
+    {
+        graph.addTask("createSemaphores", [this] { createSemaphores(); }, {targets});
+    }
+    graph.addTask("createFences", [this] { createFences(); }, {targets});
+}
+
+void Example::waitIdle(void)
+{
+    vkDeviceWaitIdle(m_device);
+}
+
+void Example::runHeadless(uint32_t frameCount)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0u; i < frameCount; i++)
+    {
+        drawOffscreenFrame();
+    }
+    vkDeviceWaitIdle(m_device);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::dec << "Rendered " << frameCount << " offscreen frames in " << elapsed.count() << " s ("
+              << (frameCount / elapsed.count()) << " frames/s)" << std::endl;
+    printRecordingStatistics();
+    finishProfiling();
+}
+
+void Example::createInstance(void)
+{
+    VkResult result;
+    uint32_t extension_count;
+    result = vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
+    if (VK_SUCCESS != result)
+    {
+        std::cout << "vkEnumerateInstanceExtensionProperties error. Unable to get extension count." << std::endl;
+    }
+
+    m_available_extensions.resize(extension_count);
+
+    result = vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, &m_available_extensions[0]);
+    if (VK_SUCCESS != result)
+    {
+        std::cout << "vkEnumerateInstanceExtensionProperties error. Unable to get extensions." << std::endl;
+    }
+
+    for (auto const& extension : m_available_extensions)
+    {
+        std::cout << extension.extensionName << std::endl;
+    }
+
+    uint32_t property_count;
+    std::vector<VkLayerProperties> available_layers;
+    result = vkEnumerateInstanceLayerProperties(&property_count, nullptr);
+    printResult(result, "Enumerating layer properties");
+    available_layers.resize(property_count);
+    result = vkEnumerateInstanceLayerProperties(&property_count, &available_layers[0]);
+
+    for (auto const& layer : available_layers)
+    {
+        std::cout << layer.layerName << std::endl;
+    }
+
+    /* Render farm machines have no SDK installed, enable only the layers which are really there */
+    std::vector<const char *> enabled_layers;
+    for (auto const& required_layer : m_required_validation_layers)
+    {
+        for (auto const& layer : available_layers)
+        {
+            if (0 == strcmp(required_layer, layer.layerName))
+            {
+                enabled_layers.push_back(required_layer);
+                break;
+            }
+        }
+    }
+
+    VkInstanceCreateInfo ici = 
+    {
+        .sType                      = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+        .pNext                      = nullptr,
+        .flags                      = 0,
+        .pApplicationInfo           = nullptr,
+        .enabledLayerCount          = (uint32_t) enabled_layers.size(),
+        .ppEnabledLayerNames        = enabled_layers.data(),
+        .enabledExtensionCount      = (uint32_t) m_required_instance_extensions.size(),
+        .ppEnabledExtensionNames    = m_required_instance_extensions.data(),
+    };
+
+    result = vkCreateInstance(&ici, nullptr, &m_instance);
+
+    printResult(result, "Instance creation result");   
+}
+
+void Example::createDevice(void)
+{
+    VkResult result;
+
+    uint32_t queue_count;
+
+    uint32_t device_count;
+
+    uint32_t extensionPropertiesCount;
+    std::vector<VkExtensionProperties> deviceExtensionsProperties;
+
+    VkPhysicalDeviceFeatures physicalDeviceFeatures = {0u};
+    VkPhysicalDeviceFeatures supportedFeatures;
+    physicalDeviceFeatures.depthClamp = VK_TRUE;
+
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+
+    vkEnumeratePhysicalDevices(m_instance, &device_count, nullptr);
+
+    m_available_devices.resize(device_count);
+
+    vkEnumeratePhysicalDevices(m_instance, &device_count, &m_available_devices[0]);
+
+    /* Score all devices, a preference from the command line or the environment wins over the score */
+    std::string preference = m_devicePreference;
+    const char * environmentPreference = getenv(DEVICE_PREFERENCE_ENV);
+    if (preference.empty() && (nullptr != environmentPreference))
+    {
+        preference = environmentPreference;
+    }
+
+    std::vector<DeviceCandidate> candidates = rankPhysicalDevices(m_available_devices, m_requiredPhysicalDeviceExtension,
+                                                                  (VK_TRUE == m_headless) ? VK_NULL_HANDLE : m_surface);
+    m_selected_device = selectPhysicalDevice(candidates, preference);
+    std::cout << "Selected device " << std::dec << m_selected_device << ": " << candidates[m_selected_device].properties.deviceName
+              << (preference.empty() ? "" : " (requested)") << std::endl;
+
+    vkEnumerateDeviceExtensionProperties(m_available_devices[m_selected_device], nullptr, &extensionPropertiesCount, nullptr);
+    deviceExtensionsProperties.resize(extensionPropertiesCount);
+
+    vkEnumerateDeviceExtensionProperties(m_available_devices[m_selected_device], nullptr, &extensionPropertiesCount, &deviceExtensionsProperties[0]);
+
+    for (const auto & property : deviceExtensionsProperties)
+    {
+        std::cout << property.extensionName << ", version: " << property.specVersion << std::endl;
+    }
+
+    std::cout << "Getting queue family properties:" << std::endl;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_available_devices[m_selected_device], &queue_count, nullptr);
+
+    std::cout << "Number of queues: " << queue_count << std::endl;
+    m_queueFamilyProperties.resize(queue_count);
+
+    vkGetPhysicalDeviceQueueFamilyProperties(m_available_devices[m_selected_device], &queue_count, &m_queueFamilyProperties[0]);
+
+    /* select queue with graphics and present capabilities */
+    uint8_t i = 0u;
+    VkBool32 presentSupport;
+    for (const auto& queue : m_queueFamilyProperties)
+    {
+        std::cout << "Flags: " << queue.queueFlags << std::endl;
+        std::cout << "Queue count: " << queue.queueCount << std::endl << std::endl;
+
+        if (0u != (queue.queueFlags & VK_QUEUE_GRAPHICS_BIT))
+        {
+            m_graphics_queue_idx = i;
+        }
+
+        if (VK_FALSE == m_headless)
+        {
+            vkGetPhysicalDeviceSurfaceSupportKHR(m_available_devices[m_selected_device], i, m_surface, &presentSupport);
+            if (VK_TRUE == presentSupport)
+            {
+                m_present_queue_idx = i;
+            }
+        }
+
+        i++;
+    }
+
+    if (VK_TRUE == m_headless)
+    {
+        /* Nothing is presented, keep everything on the graphics queue */
+        m_present_queue_idx = m_graphics_queue_idx;
+    }
+
+    /* Uploads prefer a transfer only family (DMA engine), then any non graphics family, then the graphics queue itself */
+    m_transfer_queue_idx = getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (UINT32_MAX == m_transfer_queue_idx)
+    {
+        m_transfer_queue_idx = getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT);
+    }
+    if (UINT32_MAX == m_transfer_queue_idx)
+    {
+        m_transfer_queue_idx = m_graphics_queue_idx;
+    }
+
+    m_timestampValidBits = m_queueFamilyProperties[m_graphics_queue_idx].timestampValidBits;
+
+    /* Statistics queries active around vkCmdExecuteCommands also need inherited queries */
+    vkGetPhysicalDeviceFeatures(m_available_devices[m_selected_device], &supportedFeatures);
+    if (VK_TRUE == m_pipelineStatisticsEnabled)
+    {
+        if ((VK_TRUE == supportedFeatures.pipelineStatisticsQuery) && (VK_TRUE == supportedFeatures.inheritedQueries))
+        {
+            physicalDeviceFeatures.pipelineStatisticsQuery = VK_TRUE;
+            physicalDeviceFeatures.inheritedQueries = VK_TRUE;
+        }
+        else
+        {
+            std::cout << "Pipeline statistics queries not supported, collecting timestamps only" << std::endl;
+            m_pipelineStatisticsEnabled = VK_FALSE;
+        }
+    }
+
+    /* One queue per used family; the transfer queue takes a second queue of a shared family when there is one */
+    std::vector<uint32_t> queueCounts(queue_count, 0u);
+    queueCounts[m_graphics_queue_idx] = 1u;
+    queueCounts[m_present_queue_idx] = 1u;
+    uint32_t transferQueueIndex = std::min(queueCounts[m_transfer_queue_idx], m_queueFamilyProperties[m_transfer_queue_idx].queueCount - 1u);
+    queueCounts[m_transfer_queue_idx] = std::max(queueCounts[m_transfer_queue_idx], transferQueueIndex + 1u);
+
+    float queuePriorities[2u] = {1.f, 1.f};
+    for (uint32_t family = 0u; family < queue_count; family++)
+    {
+        if (0u == queueCounts[family])
+        {
+            continue;
+        }
+
+        VkDeviceQueueCreateInfo qci =
+            {
+                .sType              = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .pNext              = nullptr,
+                .flags              = 0u,
+                .queueFamilyIndex   = family,
+                .queueCount         = queueCounts[family],
+                .pQueuePriorities   = queuePriorities,
+            };
+
+        queueCreateInfos.push_back(qci);
+    }
+
+    VkDeviceCreateInfo dci = 
+    {
+        .sType                      = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext                      = nullptr,
+        .flags                      = 0,
+        .queueCreateInfoCount       = (uint32_t) queueCreateInfos.size(),
+        .pQueueCreateInfos          = &queueCreateInfos[0],
+        .enabledLayerCount          = 0u,
+        .ppEnabledLayerNames        = nullptr,
+        .enabledExtensionCount      = (uint32_t) m_requiredPhysicalDeviceExtension.size(),
+        .ppEnabledExtensionNames    = m_requiredPhysicalDeviceExtension.data(),
+        .pEnabledFeatures           = &physicalDeviceFeatures,
+    };
+
+    result = vkCreateDevice(m_available_devices[m_selected_device], &dci, nullptr, &m_device);
+    printResult(result, "Device creation result");
+
+    vkGetDeviceQueue(m_device, m_graphics_queue_idx, 0u, &m_graphicsQueue);
+    vkGetDeviceQueue(m_device, m_present_queue_idx, 0u, &m_presentQueue);
+    vkGetDeviceQueue(m_device, m_transfer_queue_idx, transferQueueIndex, &m_transferQueue);
+
+    vkGetPhysicalDeviceMemoryProperties(m_available_devices[m_selected_device], &m_memoryProperties);
+    m_allocator.init(m_available_devices[m_selected_device], m_device);
+
+    /* Render pass, pipelines and attachments are created concurrently, all need format and sample count */
+    selectDepthFormat();
+    selectSampleCount();
+}
+
+uint32_t Example::getQueueFamilyIndex(VkQueueFlags required, VkQueueFlags avoided)
+{
+    /* First family with all required and none of the avoided capabilities, UINT32_MAX if there is none */
+    for (uint32_t i = 0u; i < m_queueFamilyProperties.size(); i++)
+    {
+        VkQueueFlags flags = m_queueFamilyProperties[i].queueFlags;
+        if ((required == (flags & required)) && (0u == (flags & avoided)) && (0u != m_queueFamilyProperties[i].queueCount))
+        {
+            return i;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+uint32_t Example::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+{
+    /* Memory types are ordered by the driver from the most to the least performant, first match wins */
+    for (uint32_t i = 0u; i < m_memoryProperties.memoryTypeCount; i++)
+    {
+        if ((0u != (typeBits & (1u << i))) &&
+            (properties == (m_memoryProperties.memoryTypes[i].propertyFlags & properties)))
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Unable to find suitable memory type!");
+}
+
+void Example::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer & buffer, MemoryAllocation & memory)
+{
+    VkResult result;
+    VkBufferCreateInfo bci = 
+    {
+        .sType                  = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .size                   = size,
+        .usage                  = usage,
+        .sharingMode            = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount  = 0u,
+        .pQueueFamilyIndices    = nullptr,
+    };
+    result = vkCreateBuffer(m_device, &bci, nullptr, &buffer);
+    printResult(result, "Buffer creation result");
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(m_device, buffer, &memoryRequirements);
+
+    memory = m_allocator.allocate(memoryRequirements, findMemoryType(memoryRequirements.memoryTypeBits, properties), SUBALLOCATION_LINEAR);
+
+    result = vkBindBufferMemory(m_device, buffer, memory.memory, memory.offset);
+    printResult(result, "Binding memory result");
+}
+
+void Example::uploadBuffer(const void * data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer & buffer, MemoryAllocation & memory)
+{
+    /* The GPU only ever reads the device local copy; the copy runs on the transfer queue and is acquired by the first frame */
+    createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+
+    m_uploader.upload(buffer, 0u, data, size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+}
+
+static const char * getPresentModeName(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:     return "IMMEDIATE";
+        case VK_PRESENT_MODE_MAILBOX_KHR:       return "MAILBOX";
+        case VK_PRESENT_MODE_FIFO_KHR:          return "FIFO";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:  return "FIFO_RELAXED";
+        default:                                return "UNKNOWN";
+    }
+}
+
+bool Example::parsePresentMode(const char * name, VkPresentModeKHR & presentMode)
+{
+    if (0 == strcmp(name, "fifo"))              presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    else if (0 == strcmp(name, "fifo_relaxed")) presentMode = VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+    else if (0 == strcmp(name, "mailbox"))      presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+    else if (0 == strcmp(name, "immediate"))    presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+    else                                        return false;
+    return true;
+}
+
+void Example::setPresentMode(VkPresentModeKHR presentMode)
+{
+    m_requestedPresentMode = presentMode;
+}
+
+void Example::setSwapchainImageCount(uint32_t imageCount)
+{
+    m_requestedImageCount = imageCount;
+}
+
+void Example::setFramesInFlight(uint32_t framesInFlight)
+{
+    if (0u == framesInFlight)
+    {
+        throw std::runtime_error("At least one frame in flight is required!");
+    }
+    m_maxInflightSubmissions = framesInFlight;
+}
+
+VkPresentModeKHR Example::selectPresentMode(void)
+{
+    /*
+     * Closest supported mode that never tears where the requested one does not: MAILBOX falls back to FIFO,
+     * IMMEDIATE to MAILBOX (still uncapped, without tearing), then FIFO. FIFO is the only mode every surface has.
+     */
+    std::vector<VkPresentModeKHR> candidates;
+    switch (m_requestedPresentMode)
+    {
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            candidates = {VK_PRESENT_MODE_MAILBOX_KHR};
+            break;
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            candidates = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR};
+            break;
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            candidates = {VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+            break;
+        default:
+            break;
+    }
+
+    for (auto candidate : candidates)
+    {
+        if (std::find(m_presentModes.begin(), m_presentModes.end(), candidate) != m_presentModes.end())
+        {
+            if (candidate != m_requestedPresentMode)
+            {
+                std::cout << "Present mode " << getPresentModeName(m_requestedPresentMode) << " not supported, using " << getPresentModeName(candidate) << std::endl;
+            }
+            return candidate;
+        }
+    }
+
+    if (VK_PRESENT_MODE_FIFO_KHR != m_requestedPresentMode)
+    {
+        std::cout << "Present mode " << getPresentModeName(m_requestedPresentMode) << " not supported, using FIFO" << std::endl;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+void Example::createSwapchain(void)
+{
+    VkResult result;
+
+    result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_available_devices[m_selected_device], m_surface, &m_surfaceCapabilities);
+    printResult(result, "Request for surface capabilities result");
+
+
+    uint32_t presentModeCount;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(m_available_devices[m_selected_device], m_surface, &presentModeCount, nullptr);
+
+    m_presentModes.resize(presentModeCount);
+    result = vkGetPhysicalDeviceSurfacePresentModesKHR(m_available_devices[m_selected_device], m_surface, &presentModeCount, &m_presentModes[0u]);
+    printResult(result, "Request for surface present modes result");
+
+    uint32_t formatCount;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(m_available_devices[m_selected_device], m_surface, &formatCount, nullptr);
+
+    m_surfaceFormats.resize(formatCount);
+    result = vkGetPhysicalDeviceSurfaceFormatsKHR(m_available_devices[m_selected_device], m_surface, &formatCount, &m_surfaceFormats[0u]);
+    printResult(result, "Request for surface formats result");
+
+    /* Requested image count clamped to the surface limits, maxImageCount 0 means no upper limit */
+    uint32_t imageCount = std::max(m_requestedImageCount, m_surfaceCapabilities.minImageCount);
+    if ((0u != m_surfaceCapabilities.maxImageCount) && (imageCount > m_surfaceCapabilities.maxImageCount))
+    {
+        imageCount = m_surfaceCapabilities.maxImageCount;
+    }
+
+    m_isDoubleBufferingSupported = ((m_surfaceCapabilities.maxImageCount > 1u) || (m_surfaceCapabilities.maxImageCount == 0u)) ? VK_TRUE : VK_FALSE;
+    m_isTrippleBufferingSupported = ((m_surfaceCapabilities.maxImageCount > 2u) || (m_surfaceCapabilities.maxImageCount == 0u)) ? VK_TRUE : VK_FALSE;
+    m_selectedBufferingMode = (imageCount >= 3u) ? TRIPPLE_BUFFERING : DOUBLE_BUFFERING;
+
+    if (imageCount != m_requestedImageCount)
+    {
+        std::cout << std::dec << "Requested " << m_requestedImageCount << " swapchain images, surface supports "
+                  << m_surfaceCapabilities.minImageCount << ".." << m_surfaceCapabilities.maxImageCount << ", using " << imageCount << std::endl;
+    }
+
+    VkPresentModeKHR presentMode = selectPresentMode();
+
+    /* The surface either dictates the extent or leaves it to the swapchain, then the window's framebuffer size is used */
+    VkExtent2D extent = m_surfaceCapabilities.currentExtent;
+    if (UINT32_MAX == extent.width)
+    {
+        int width, height;
+        glfwGetFramebufferSize(m_window, &width, &height);
+        extent.width = std::min(std::max((uint32_t) width, m_surfaceCapabilities.minImageExtent.width), m_surfaceCapabilities.maxImageExtent.width);
+        extent.height = std::min(std::max((uint32_t) height, m_surfaceCapabilities.minImageExtent.height), m_surfaceCapabilities.maxImageExtent.height);
+    }
+
+    uint32_t queueFamilyIndices[1u] = {m_graphics_queue_idx};
+
+    VkSwapchainCreateInfoKHR sci = 
+    {
+        .sType                  = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .surface                = m_surface,
+        .minImageCount          = imageCount,
+        .imageFormat            = m_surfaceFormats[3u].format,
+        .imageColorSpace        = m_surfaceFormats[3u].colorSpace,
+        .imageExtent            = extent,
+        .imageArrayLayers       = 1u,
+        .imageUsage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageSharingMode       = (m_graphics_queue_idx == m_present_queue_idx) ? VK_SHARING_MODE_EXCLUSIVE : VK_SHARING_MODE_CONCURRENT,
+        .queueFamilyIndexCount  = 1u,
+        .pQueueFamilyIndices    = queueFamilyIndices,
+        .preTransform           = m_surfaceCapabilities.currentTransform,
+        .compositeAlpha         = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+        .presentMode            = presentMode,
+        .clipped                = VK_TRUE,
+        .oldSwapchain           = m_swapchain,      /* on a resize the replaced swapchain, its resources can be reused */
+    };
+
+    bool recreation = (VK_NULL_HANDLE != m_swapchain);
+    result = vkCreateSwapchainKHR(m_device, &sci, nullptr, &m_swapchain);
+    printResult(result, "Swapchain creation result");
+
+    m_colorFormat = m_surfaceFormats[3u].format;
+    m_extent = extent;
+
+    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, nullptr);
+    m_swapchainImages.resize(imageCount);
+    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, &m_swapchainImages[0u]);
+
+    /* Everything sized by the frames in flight is kept on a resize, only the swapchain sized resources are recreated */
+    if (recreation)
+    {
+        std::cout << std::dec << "Swapchain recreated: " << m_extent.width << "x" << m_extent.height << ", " << imageCount << " images" << std::endl;
+        return;
+    }
+
+    /* The driver may create more images than requested, but never run more frames ahead than there are images */
+    if (m_maxInflightSubmissions > imageCount)
+    {
+        std::cout << std::dec << "Frames in flight limited to the swapchain image count " << imageCount << std::endl;
+        m_maxInflightSubmissions = imageCount;
+    }
+
+    std::cout << std::dec << "Swapchain: " << imageCount << " images, present mode " << getPresentModeName(presentMode)
+              << ", " << m_maxInflightSubmissions << " frames in flight" << std::endl;
+}
+
+void Example::createOffscreenTargets(void)
+{
+    VkResult result;
+
+    /* Offscreen color targets stand in for swapchain images, one per frame in flight */
+    m_colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    VkImageCreateInfo imageInfo =
+    {
+        .sType                  = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .imageType              = VK_IMAGE_TYPE_2D,
+        .format                 = m_colorFormat,
+        .extent                 = {m_extent.width, m_extent.height, 1u},
+        .mipLevels              = 1u,
+        .arrayLayers            = 1u,
+        .samples                = VK_SAMPLE_COUNT_1_BIT,
+        .tiling                 = VK_IMAGE_TILING_OPTIMAL,
+        .usage                  = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode            = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount  = 0u,
+        .pQueueFamilyIndices    = nullptr,
+        .initialLayout          = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    m_swapchainImages.resize(m_maxInflightSubmissions);
+    m_offscreenImageMemory.resize(m_maxInflightSubmissions);
+
+    for (uint32_t i = 0u; i < m_maxInflightSubmissions; i++)
+    {
+        result = vkCreateImage(m_device, &imageInfo, nullptr, &m_swapchainImages[i]);
+        printResult(result, "Offscreen image creation result");
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(m_device, m_swapchainImages[i], &memRequirements);
+
+        m_offscreenImageMemory[i] = m_allocator.allocate(memRequirements, findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT), SUBALLOCATION_OPTIMAL);
+        vkBindImageMemory(m_device, m_swapchainImages[i], m_offscreenImageMemory[i].memory, m_offscreenImageMemory[i].offset);
+    }
+}
+
+void Example::createImageViews(void)
+{
+    VkResult result;
+    m_swapchainImageViews.resize(m_swapchainImages.size());
+    
+    VkImageViewCreateInfo ivci = 
+    {
+        .sType              = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .viewType           = VK_IMAGE_VIEW_TYPE_2D,
+        .format             = m_colorFormat,
+        .components         = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+        .subresourceRange   = {VK_IMAGE_ASPECT_COLOR_BIT, 0u, 1u, 0u, 1u},
+    };
+
+    for (uint32_t i = 0u; i < m_swapchainImages.size(); i++)
+    {
+        ivci.image = m_swapchainImages[i];
+        result = vkCreateImageView(m_device, &ivci, nullptr, &m_swapchainImageViews[i]);
+        printResult(result, "Image view creation result");
+    }
+}
+
+static const char * getDepthFormatName(VkFormat format)
+{
+    switch (format)
+    {
+        case VK_FORMAT_D16_UNORM:           return "D16_UNORM";
+        case VK_FORMAT_D24_UNORM_S8_UINT:   return "D24_UNORM_S8_UINT";
+        case VK_FORMAT_D32_SFLOAT:          return "D32_SFLOAT";
+        default:                            return "UNKNOWN";
+    }
+}
+
+bool Example::parseDepthFormat(const char * name, VkFormat & format)
+{
+    if (0 == strcmp(name, "d16"))           format = VK_FORMAT_D16_UNORM;
+    else if (0 == strcmp(name, "d24s8"))    format = VK_FORMAT_D24_UNORM_S8_UINT;
+    else if (0 == strcmp(name, "d32"))      format = VK_FORMAT_D32_SFLOAT;
+    else                                    return false;
+    return true;
+}
+
+void Example::setDepthFormat(VkFormat format)
+{
+    m_requestedDepthFormat = format;
+}
+
+void Example::selectDepthFormat(void)
+{
+    /*
+     * Requested format first, then by precision. Only D16_UNORM is guaranteed as a depth attachment,
+     * every device has at least one of D24_UNORM_S8_UINT and D32_SFLOAT as well.
+     */
+    std::vector<VkFormat> candidates = {m_requestedDepthFormat, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM};
+
+    for (auto candidate : candidates)
+    {
+        VkFormatProperties formatProperties;
+        vkGetPhysicalDeviceFormatProperties(m_available_devices[m_selected_device], candidate, &formatProperties);
+        if (0u != (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT))
+        {
+            if (candidate != m_requestedDepthFormat)
+            {
+                std::cout << "Depth format " << getDepthFormatName(m_requestedDepthFormat) << " not supported, using " << getDepthFormatName(candidate) << std::endl;
+            }
+            m_depthFormat = candidate;
+            return;
+        }
+    }
+
+    throw std::runtime_error("No supported depth format!");
+}
+
+void Example::setSampleCount(uint32_t sampleCount)
+{
+    m_requestedSampleCount = sampleCount;
+}
+
+void Example::selectSampleCount(void)
+{
+    /* Highest count not above the request that color and depth attachments both support, 1 sample always is */
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_available_devices[m_selected_device], &properties);
+    VkSampleCountFlags supported = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+
+    m_sampleCount = VK_SAMPLE_COUNT_1_BIT;
+    for (uint32_t count = VK_SAMPLE_COUNT_64_BIT; count > VK_SAMPLE_COUNT_1_BIT; count >>= 1u)
+    {
+        if ((count <= m_requestedSampleCount) && (0u != (supported & count)))
+        {
+            m_sampleCount = (VkSampleCountFlagBits) count;
+            break;
+        }
+    }
+
+    if ((uint32_t) m_sampleCount != m_requestedSampleCount)
+    {
+        std::cout << std::dec << "MSAA " << m_requestedSampleCount << "x not supported, using " << (uint32_t) m_sampleCount << "x" << std::endl;
+    }
+}
+
+uint32_t Example::getSampleCount(void)
+{
+    return (uint32_t) m_sampleCount;
+}
+
+uint32_t Example::findTransientMemoryType(uint32_t typeBits)
+{
+    /* Transient attachments may report lazily allocated types only on tilers, everything else gets plain device local memory */
+    for (uint32_t i = 0u; i < m_memoryProperties.memoryTypeCount; i++)
+    {
+        if ((0u != (typeBits & (1u << i))) &&
+            (0u != (m_memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)))
+        {
+            return i;
+        }
+    }
+
+    return findMemoryType(typeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void Example::createFrameGraph(void)
+{
+    VkImageLayout presentLayout = (VK_TRUE == m_headless) ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    VkPipelineStageFlags depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    VkAccessFlags depthAccess = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (VK_FORMAT_D24_UNORM_S8_UINT == m_depthFormat)
+    {
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    /* Buffers are per frame in flight, the frame's fence already waited for their previous use */
+    uint32_t instances = m_frameGraph.importBuffer("instances", {0, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+    uint32_t visibleInstances = m_frameGraph.importBuffer("visible_instances", {0, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+    uint32_t indirect = m_frameGraph.importBuffer("indirect_draw", {0, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+
+    /* The target is discarded on load and waits for the image ready semaphore, which is waited at the color output stage */
+    m_targetResource = m_frameGraph.importImage("target", VK_IMAGE_ASPECT_COLOR_BIT, {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+    m_frameGraph.exportResource(m_targetResource, {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, presentLayout});
+
+    /*
+     * Depth and the multisampled color target never leave the render pass (cleared on load, resolved, not stored),
+     * so they are transient attachments owned by the graph: one per frame in flight instead of one per swapchain
+     * image, backed by lazily allocated memory that tilers never commit. The frame's fence already waited for the
+     * previous frame that used the same copy.
+     */
+    VkImageCreateInfo imageInfo =
+    {
+        .sType                  = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .imageType              = VK_IMAGE_TYPE_2D,
+        .format                 = m_depthFormat,
+        .extent                 = {m_extent.width, m_extent.height, 1u},
+        .mipLevels              = 1u,
+        .arrayLayers            = 1u,
+        .samples                = m_sampleCount,
+        .tiling                 = VK_IMAGE_TILING_OPTIMAL,
+        .usage                  = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+        .sharingMode            = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout          = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    m_depthResource = m_frameGraph.createImage("depth", imageInfo, depthAspect);
+    if (VK_SAMPLE_COUNT_1_BIT != m_sampleCount)
+    {
+        imageInfo.format = m_colorFormat;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        m_colorResource = m_frameGraph.createImage("msaa_color", imageInfo, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+
+    /* Nothing reads the culling results without --gpu-cull, so both culling passes are culled by the graph */
+    uint32_t reset = m_frameGraph.addPass("cull_reset", [this](VkCommandBuffer commandBuffer, const FrameGraphContext & context)
+    {
+        recordCullingReset(commandBuffer, context.frame);
+    });
+    m_frameGraph.write(reset, indirect, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    uint32_t cull = m_frameGraph.addPass("cull", [this](VkCommandBuffer commandBuffer, const FrameGraphContext & context)
+    {
+        recordCulling(commandBuffer, context.frame);
+    });
+    m_frameGraph.read(cull, instances, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    m_frameGraph.read(cull, indirect, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    m_frameGraph.write(cull, indirect, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    m_frameGraph.write(cull, visibleInstances, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+    m_mainRenderPass = m_frameGraph.addRenderPass("main", [this](VkCommandBuffer commandBuffer, const FrameGraphContext & context)
+    {
+        VkClearValue clearValues[3];
+        clearValues[0].color = {{0.f, 0.f, 0.f, 0.f}};
+        clearValues[1].depthStencil = {1.f, 0u};
+        clearValues[2].color = {{0.f, 0.f, 0.f, 0.f}};      /* resolve attachment, not cleared */
+        VkRenderPassBeginInfo rpbi = {
+            .sType          = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+            .pNext          = NULL,
+            .renderPass     = m_renderPass,
+            .framebuffer    = m_framebuffers[context.target * m_maxInflightSubmissions + context.frame],
+            .renderArea     = {{0, 0}, m_extent},
+            .clearValueCount = (VK_SAMPLE_COUNT_1_BIT != m_sampleCount) ? 3u : 2u,
+            .pClearValues   = clearValues,
+        };
+        vkCmdBeginRenderPass(commandBuffer, &rpbi, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    /* Both subpasses draw the same instances, either the culling survivors or all of them */
+    auto readInstances = [&](uint32_t pass)
+    {
+        if (VK_TRUE == m_gpuCulling)
+        {
+            m_frameGraph.read(pass, indirect, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+            m_frameGraph.read(pass, visibleInstances, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        }
+        else
+        {
+            m_frameGraph.read(pass, instances, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        }
+    };
+
+    if (VK_TRUE == m_depthPrepass)
+    {
+        uint32_t depthPass = m_frameGraph.addPass("depth_prepass", [this](VkCommandBuffer commandBuffer, const FrameGraphContext & context)
+        {
+            vkCmdExecuteCommands(commandBuffer, m_frameCommands[context.frame].sliceCount, m_frameCommands[context.frame].depthSecondaries.data());
+        }, m_mainRenderPass);
+        readInstances(depthPass);
+        m_frameGraph.writeAttachment(depthPass, m_depthResource, depthStages, depthAccess, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    }
+
+    uint32_t colorPass = m_frameGraph.addPass("color", [this](VkCommandBuffer commandBuffer, const FrameGraphContext & context)
+    {
+        vkCmdExecuteCommands(commandBuffer, m_frameCommands[context.frame].sliceCount, m_frameCommands[context.frame].secondaries.data());
+    }, m_mainRenderPass);
+    readInstances(colorPass);
+    if (VK_TRUE == m_depthPrepass)
+    {
+        m_frameGraph.readAttachment(colorPass, m_depthResource, depthStages, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+    }
+    else
+    {
+        m_frameGraph.writeAttachment(colorPass, m_depthResource, depthStages, depthAccess, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+    }
+    if (FRAME_GRAPH_NONE != m_colorResource)
+    {
+        m_frameGraph.writeAttachment(colorPass, m_colorResource, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    }
+    m_frameGraph.writeAttachment(colorPass, m_targetResource, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+    /* One set of graph owned images per frame in flight, final once the swapchain exists */
+    m_frameGraph.compile(m_device, m_allocator, [this](uint32_t typeBits) { return findTransientMemoryType(typeBits); }, m_maxInflightSubmissions);
+    m_frameGraph.printSummary();
+
+    uint32_t depthMemoryType = m_frameGraph.getMemoryType(m_depthResource);
+    VkBool32 lazy = (0u != (m_memoryProperties.memoryTypes[depthMemoryType].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) ? VK_TRUE : VK_FALSE;
+    std::cout << std::dec << "Depth: " << m_maxInflightSubmissions << "x " << getDepthFormatName(m_depthFormat) << " " << m_extent.width << "x" << m_extent.height
+              << ", transient" << ((VK_TRUE == lazy) ? ", lazily allocated" : "") << std::endl;
+}
+
+void Example::createRenderPass(void)
+{
+    VkResult result;
+    bool multisampled = (VK_SAMPLE_COUNT_1_BIT != m_sampleCount);
+
+    /* With MSAA the color attachment is the transient multisampled target and the swapchain image is the resolve attachment */
+    VkAttachmentDescription attachment_descriptions[] = 
+    {
+        /* Color attachment */
+        {
+            .flags          = 0,
+            .format         = m_colorFormat,
+            .samples        = m_sampleCount,
+            .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp        = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout    = m_frameGraph.getFinalLayout(m_mainRenderPass, multisampled ? m_colorResource : m_targetResource),
+        },
+        /* Depth attachment */
+        {
+            .flags          = 0,
+            .format         = m_depthFormat,
+            .samples        = m_sampleCount,
+            .loadOp         = VK_ATTACHMENT_LOAD_OP_CLEAR,
+            .storeOp        = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout    = m_frameGraph.getFinalLayout(m_mainRenderPass, m_depthResource),
+        },
+        /* Resolve attachment, completely overwritten by the resolve */
+        {
+            .flags          = 0,
+            .format         = m_colorFormat,
+            .samples        = VK_SAMPLE_COUNT_1_BIT,
+            .loadOp         = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .storeOp        = VK_ATTACHMENT_STORE_OP_STORE,
+            .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+            .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
+            .finalLayout    = m_frameGraph.getFinalLayout(m_mainRenderPass, m_targetResource),
+        }
+    };
+
+    VkAttachmentReference color_attachment_references[] = 
+    {
+        {
+            .attachment = 0u,
+            .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        }
+    };
+
+    /* Resolved at the end of the color subpass, no separate resolve or blit pass */
+    VkAttachmentReference resolve_attachment_references[] =
+    {
+        {
+            .attachment = 2u,
+            .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        }
+    };
+
+    /* The color pass of the depth pre-pass mode only tests against the finished depth buffer */
+    VkAttachmentReference depth_attachment_references[] =
+    {
+        {
+            .attachment = 1u,
+            .layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        },
+        {
+            .attachment = 1u,
+            .layout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+        }
+    };
+
+    /* Subpass 0 is either the only pass or the depth-only pre-pass, the color pass follows it in subpass 1 */
+    VkSubpassDescription sds[] = 
+    {
+        {
+            .flags                      = 0,
+            .pipelineBindPoint          = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .inputAttachmentCount       = 0u,
+            .pInputAttachments          = nullptr,
+            .colorAttachmentCount       = (VK_TRUE == m_depthPrepass) ? 0u : 1u,
+            .pColorAttachments          = (VK_TRUE == m_depthPrepass) ? nullptr : color_attachment_references,
+            .pResolveAttachments        = ((VK_TRUE == m_depthPrepass) || !multisampled) ? nullptr : resolve_attachment_references,
+            .pDepthStencilAttachment    = &depth_attachment_references[0],
+            .preserveAttachmentCount    = 0u,
+            .pPreserveAttachments       = nullptr,
+        },
+        {
+            .flags                      = 0,
+            .pipelineBindPoint          = VK_PIPELINE_BIND_POINT_GRAPHICS,
+            .inputAttachmentCount       = 0u,
+            .pInputAttachments          = nullptr,
+            .colorAttachmentCount       = 1u,
+            .pColorAttachments          = color_attachment_references,
+            .pResolveAttachments        = multisampled ? resolve_attachment_references : nullptr,
+            .pDepthStencilAttachment    = &depth_attachment_references[1],
+            .preserveAttachmentCount    = 0u,
+            .pPreserveAttachments       = nullptr,
+        }
+    };
+
+    /* Derived by the frame graph from the accesses of the subpasses, see createFrameGraph() */
+    const std::vector<VkSubpassDependency> & dependencies = m_frameGraph.getSubpassDependencies(m_mainRenderPass);
+    uint32_t subpassCount = (VK_TRUE == m_depthPrepass) ? 2u : 1u;
+
+    VkRenderPassCreateInfo rpci = 
+    {
+        .sType              = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .attachmentCount    = multisampled ? 3u : 2u,
+        .pAttachments       = attachment_descriptions,
+        .subpassCount       = subpassCount,
+        .pSubpasses         = sds,
+        .dependencyCount    = (uint32_t) dependencies.size(),
+        .pDependencies      = dependencies.data(),
+    };
+
+    result = vkCreateRenderPass(m_device, &rpci, nullptr, &m_renderPass);
+    printResult(result, "Renderpass creation result");
+}
+
+void Example::createFramebuffers(void)
+{
+    VkResult result;
+    VkFramebufferCreateInfo fci =
+    {
+        .sType              = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .renderPass         = m_renderPass,
+        .attachmentCount    = (VK_SAMPLE_COUNT_1_BIT != m_sampleCount) ? 3u : 2u,
+        .pAttachments       = nullptr,
+        .width              = m_extent.width,
+        .height             = m_extent.height,
+        .layers             = 1u,
+    };
+
+    /*
+     * Any swapchain image may be acquired by any frame in flight, and depth and MSAA color belong to the frame,
+     * so there is a framebuffer for every pair: index = image * frames in flight + frame
+     */
+    uint32_t frameCount = m_maxInflightSubmissions;
+    m_framebuffers.resize(m_swapchainImageViews.size() * frameCount);
+
+    for (uint32_t i = 0u; i < m_swapchainImageViews.size(); i++)
+    {
+        for (uint32_t f = 0u; f < frameCount; f++)
+        {
+            /* Same order as the render pass attachments, the swapchain image is the resolve target with MSAA */
+            VkImageView attachments[] = {m_swapchainImageViews[i], m_frameGraph.getImageView(m_depthResource, f), VK_NULL_HANDLE};
+            if (VK_SAMPLE_COUNT_1_BIT != m_sampleCount)
+            {
+                attachments[0] = m_frameGraph.getImageView(m_colorResource, f);
+                attachments[2] = m_swapchainImageViews[i];
+            }
+            fci.pAttachments = attachments;
+
+            result = vkCreateFramebuffer(m_device, &fci, nullptr, &m_framebuffers[i * frameCount + f]);
+            printResult(result, "Framebuffer creation result");
+        }
+    }
+}
+
+/* Checks the VkPipelineCacheHeaderVersionOne header, a cache from another driver or GPU is dropped instead of handed to the driver */
+static bool isPipelineCacheCompatible(const std::vector<char> & data, const VkPhysicalDeviceProperties & properties)
+{
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    const size_t uuidOffset = 4u * sizeof(uint32_t);
+
+    if (data.size() < (uuidOffset + VK_UUID_SIZE))
+    {
+        return false;
+    }
+
+    memcpy(&headerSize, &data[0], sizeof(uint32_t));
+    memcpy(&headerVersion, &data[4], sizeof(uint32_t));
+    memcpy(&vendorID, &data[8], sizeof(uint32_t));
+    memcpy(&deviceID, &data[12], sizeof(uint32_t));
+
+    return (headerSize >= (uuidOffset + VK_UUID_SIZE)) && (headerSize <= data.size()) &&
+           (VK_PIPELINE_CACHE_HEADER_VERSION_ONE == headerVersion) &&
+           (properties.vendorID == vendorID) && (properties.deviceID == deviceID) &&
+           (0 == memcmp(&data[uuidOffset], properties.pipelineCacheUUID, VK_UUID_SIZE));
+}
+
+void Example::createPipelineCache(void)
+{
+    VkResult result;
+    VkPhysicalDeviceProperties properties;
+    std::vector<char> cacheData;
+
+    vkGetPhysicalDeviceProperties(m_available_devices[m_selected_device], &properties);
+
+    /* A missing cache file is the normal first run */
+    std::ifstream file(m_pipelineCachePath, std::ios::binary);
+    if (file.is_open())
+    {
+        cacheData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        file.close();
+
+        if (!isPipelineCacheCompatible(cacheData, properties))
+        {
+            std::cout << "Pipeline cache " << m_pipelineCachePath << " was created by another device or driver, ignoring it" << std::endl;
+            cacheData.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo pcci =
+    {
+        .sType              = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .initialDataSize    = cacheData.size(),
+        .pInitialData       = cacheData.empty() ? nullptr : cacheData.data(),
+    };
+
+    result = vkCreatePipelineCache(m_device, &pcci, nullptr, &m_pipelineCache);
+    printResult(result, "Pipeline cache creation result");
+
+    m_pipelineCacheSeeded = cacheData.empty() ? VK_FALSE : VK_TRUE;
+    std::cout << std::dec << "Pipeline cache " << ((VK_TRUE == m_pipelineCacheSeeded) ? "loaded" : "empty")
+              << ", " << cacheData.size() << " B" << std::endl;
+}
+
+void Example::savePipelineCache(void)
+{
+    VkResult result;
+    size_t size = 0u;
+
+    result = vkGetPipelineCacheData(m_device, m_pipelineCache, &size, nullptr);
+    if ((VK_SUCCESS != result) || (0u == size))
+    {
+        return;
+    }
+
+    std::vector<char> cacheData(size);
+    result = vkGetPipelineCacheData(m_device, m_pipelineCache, &size, cacheData.data());
+    if (VK_SUCCESS != result)
+    {
+        printResult(result, "Pipeline cache serialization result");
+        return;
+    }
+
+    /* Written to a temporary file first, a crash while saving must not leave a truncated cache behind */
+    std::string temporaryPath = m_pipelineCachePath + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Unable to write pipeline cache " << temporaryPath << std::endl;
+        return;
+    }
+    file.write(cacheData.data(), size);
+    file.close();
+
+    std::remove(m_pipelineCachePath.c_str());
+    std::rename(temporaryPath.c_str(), m_pipelineCachePath.c_str());
+    std::cout << std::dec << "Pipeline cache saved, " << size << " B" << std::endl;
+}
+
+void Example::setShaderDirectory(const std::string & directory)
+{
+    m_shaderDirectory = directory;
+}
+
+void Example::loadShaders(void)
+{
+    /* Built-in SPIR-V needs no file system access, an override directory is memory-mapped instead of read */
+    if (m_shaderDirectory.empty())
+    {
+        m_vertexShaderCode.setEmbedded(EMBEDDED_SPIRV_VERT, sizeof(EMBEDDED_SPIRV_VERT));
+        m_fragmentShaderCode.setEmbedded(EMBEDDED_SPIRV_FRAG, sizeof(EMBEDDED_SPIRV_FRAG));
+        m_cullShaderCode.setEmbedded(EMBEDDED_SPIRV_CULL, sizeof(EMBEDDED_SPIRV_CULL));
+        m_depthShaderCode.setEmbedded(EMBEDDED_SPIRV_DEPTH, sizeof(EMBEDDED_SPIRV_DEPTH));
+    }
+    else
+    {
+        m_vertexShaderCode.mapFile(m_shaderDirectory + "/vert.spv");
+        m_fragmentShaderCode.mapFile(m_shaderDirectory + "/frag.spv");
+        if (VK_TRUE == m_gpuCulling)
+        {
+            m_cullShaderCode.mapFile(m_shaderDirectory + "/cull.spv");
+        }
+        if (VK_TRUE == m_depthPrepass)
+        {
+            m_depthShaderCode.mapFile(m_shaderDirectory + "/depth.spv");
+        }
+        std::cout << "Shaders mapped from " << m_shaderDirectory << std::endl;
+    }
+}
+
+void Example::setMeshFile(const std::string & path)
+{
+    m_meshPath = path;
+}
+
+void Example::createMeshBuffers(void)
+{
+    if (!m_meshPath.empty())
+    {
+        loadMeshFile();
+        return;
+    }
+
+    /* Convert the model into the compact GPU layout; snorm positions are scaled into [-1, 1] and scaled back in the model matrix */
+    uint32_t cubeVerticesCount = getCubeVerticesCount();
+    float maxCoord = 0.f;
+    for (uint32_t i = 0u; i < cubeVerticesCount; i++)
+    {
+        maxCoord = std::max(maxCoord, std::max(fabsf(my_cube[i].coord.x), std::max(fabsf(my_cube[i].coord.y), fabsf(my_cube[i].coord.z))));
+    }
+    m_positionScale = (VertexFormatTraits<GpuVertex>::normalizedCoord && (maxCoord > 0.f)) ? maxCoord : 1.f;
+
+    std::vector<GpuVertex> gpuVertices(cubeVerticesCount);
+    for (uint32_t i = 0u; i < cubeVerticesCount; i++)
+    {
+        gpuVertices[i] = VertexFormatTraits<GpuVertex>::encode(my_cube[i], 1.f / m_positionScale);
+    }
+
+    std::cout << "Vertex format " << VertexFormatTraits<GpuVertex>::name << ", " << std::dec << sizeof(GpuVertex)
+              << " B per vertex (" << sizeof(Vertex) << " B authored)" << std::endl;
+
+    /* Deduplicate and cache-optimize the model, then upload it once into device local memory */
+    IndexedMesh mesh = preprocessMesh(gpuVertices.data(), cubeVerticesCount, sizeof(GpuVertex));
+
+    m_indexType = selectIndexType(mesh.vertexCount);
+    m_indexCount = (uint32_t) mesh.indices.size();
+    std::vector<uint8_t> indexData = packIndices(mesh.indices, m_indexType);
+
+    uploadBuffer(mesh.vertexData.data(), mesh.vertexData.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_modelBuffer, m_modelBufferMemory);
+    uploadBuffer(indexData.data(), indexData.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, m_indexBuffer, m_indexBufferMemory);
+
+    createPositionBuffer(mesh.vertexCount);
+    uploadPositions(mesh.vertexData.data(), 0u, mesh.vertexCount, mesh.vertexStride);
+    m_uploader.flush();
+
+    /* Bounding sphere around the box of the encoded positions, the space instance offsets are applied in */
+    glm::vec3 boundsMin(my_cube[0].coord.x, my_cube[0].coord.y, my_cube[0].coord.z);
+    glm::vec3 boundsMax = boundsMin;
+    for (uint32_t i = 1u; i < cubeVerticesCount; i++)
+    {
+        glm::vec3 coord(my_cube[i].coord.x, my_cube[i].coord.y, my_cube[i].coord.z);
+        boundsMin = glm::min(boundsMin, coord);
+        boundsMax = glm::max(boundsMax, coord);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * (0.5f / m_positionScale);
+    float radius = 0.f;
+    for (uint32_t i = 0u; i < cubeVerticesCount; i++)
+    {
+        glm::vec3 coord(my_cube[i].coord.x, my_cube[i].coord.y, my_cube[i].coord.z);
+        radius = std::max(radius, glm::length(coord * (1.f / m_positionScale) - center));
+    }
+    m_boundingSphere = glm::vec4(center, radius);
+}
+
+void Example::createPositionBuffer(uint32_t vertexCount)
+{
+    /* The depth pre-pass fetches positions only, a separate tightly packed stream keeps colors out of its vertex fetch */
+    if (VK_TRUE == m_depthPrepass)
+    {
+        createBuffer((VkDeviceSize) vertexCount * VertexFormatTraits<GpuVertex>::coordSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_positionBuffer, m_positionBufferMemory);
+    }
+}
+
+void Example::uploadPositions(const uint8_t * vertexData, uint32_t firstVertex, uint32_t vertexCount, uint32_t vertexStride)
+{
+    if (VK_FALSE == m_depthPrepass)
+    {
+        return;
+    }
+
+    /* Positions are packed straight into the staging memory, vertexData holds the vertices from firstVertex on */
+    const uint32_t coordSize = VertexFormatTraits<GpuVertex>::coordSize;
+    m_uploader.upload(m_positionBuffer, (VkDeviceSize) firstVertex * coordSize, (VkDeviceSize) vertexCount * coordSize,
+        [vertexData, vertexCount, vertexStride, coordSize](void * staging)
+        {
+            uint8_t * positions = (uint8_t *) staging;
+            for (uint32_t i = 0u; i < vertexCount; i++)
+            {
+                memcpy(&positions[(size_t) i * coordSize], &vertexData[(size_t) i * vertexStride + VertexFormatTraits<GpuVertex>::coordOffset], coordSize);
+            }
+        },
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
+
+void Example::loadMeshFile(void)
+{
+    auto start = std::chrono::steady_clock::now();
+    MeshFile meshFile;
+    meshFile.open(m_meshPath);
+    MeshFileHeader header = meshFile.header();      /* copied, it is printed after the mapping is released */
+
+    /* The vertex section is the GPU layout of the converter's build, it is not converted at load time */
+    if ((VERTEX_FORMAT != header.vertexFormat) || (sizeof(GpuVertex) != header.vertexStride))
+    {
+        throw std::runtime_error("Mesh file was converted for another vertex format!");
+    }
+
+    m_indexType = (2u == header.indexSize) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    m_indexCount = header.indexCount;
+    m_positionScale = header.positionScale;
+    m_boundingSphere = glm::vec4(header.sphere[0], header.sphere[1], header.sphere[2], header.sphere[3]) * (1.f / m_positionScale);
+
+    createBuffer(header.vertexBytes, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_modelBuffer, m_modelBufferMemory);
+    createBuffer(header.indexBytes, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_indexBuffer, m_indexBufferMemory);
+    createPositionBuffer(header.vertexCount);
+
+    /*
+     * Sections are copied from the mapping into staging memory in chunks, pages that were copied are dropped again,
+     * so the file never is resident in addition to its staging copy. Chunks hold whole vertices, the position stream
+     * of the depth pre-pass is packed from the same chunk before its pages are dropped. Indices are range checked on
+     * the way, an index past the vertex section would make the GPU fetch outside of the vertex buffer.
+     */
+    struct
+    {
+        VkBuffer    buffer;
+        uint64_t    offset;
+        uint64_t    size;
+        uint32_t    elementSize;
+        bool        indices;
+    } sections[] =
+    {
+        {m_modelBuffer, header.vertexOffset, header.vertexBytes, header.vertexStride, false},
+        {m_indexBuffer, header.indexOffset, header.indexBytes, header.indexSize, true}
+    };
+
+    for (const auto & section : sections)
+    {
+        uint64_t chunkSize = MESH_UPLOAD_CHUNK_SIZE - (MESH_UPLOAD_CHUNK_SIZE % section.elementSize);
+        for (uint64_t copied = 0u; copied < section.size; copied += chunkSize)
+        {
+            uint64_t size = std::min<uint64_t>(chunkSize, section.size - copied);
+            const uint8_t * chunk = meshFile.file().data() + section.offset + copied;
+            if (section.indices && (findMaxIndex(chunk, section.elementSize, (size_t) (size / section.elementSize)) >= header.vertexCount))
+            {
+                throw std::runtime_error("Mesh file indices address vertices it does not contain!");
+            }
+            m_uploader.upload(section.buffer, copied, chunk, size,
+                              VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+            if (!section.indices)
+            {
+                uploadPositions(chunk, (uint32_t) (copied / section.elementSize), (uint32_t) (size / section.elementSize), section.elementSize);
+            }
+            meshFile.file().discard((size_t) (section.offset + copied), (size_t) size);
+        }
+    }
+    m_uploader.flush();
+    meshFile.release();
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << std::dec << "Mesh " << m_meshPath << ": " << header.vertexCount << " vertices, " << (header.indexCount / 3u) << " triangles, "
+              << (header.vertexBytes + header.indexBytes) << " B streamed in " << duration.count() << " ms" << std::endl;
+}
+
+void Example::createPipeline(void)
+{
+    /*
+    vkCreatePipelineLayout -> VkPipelineLayout
+    |-> VkPipelineLayoutCreateInfo
+        |-> VkDescriptorSetLayout
+
+    vkCreateDescriptorSetLayout -> VkDescriptorSetLayout
+    |-> VkDescriptorSetLayoutCreateInfo
+        |-> VkDescriptorSetLayoutBindings
+    
+    vkAllocateDescriptorSets -> VkDescriptorSet
+    |-> VkDescriptorSetAllocateInfo
+        |-> VkDescriptorSetLayout
+    */
+    VkResult result;
+
+    VkPipelineInputAssemblyStateCreateInfo piasci = 
+    {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        .primitiveRestartEnable = VK_FALSE, /* TODO ask about restart enable, how does it work? */
+    };
+
+    /* Binding and attributes follow the vertex layout selected at build time */
+    VkVertexInputBindingDescription vibds[] =
+    {
+        getVertexBindingDescription<GpuVertex>(0u),
+        getInstanceBindingDescription(1u)
+    };
+
+    std::array<VkVertexInputAttributeDescription, 2> vertexAttributes = getVertexAttributeDescriptions<GpuVertex>(0u);
+    std::array<VkVertexInputAttributeDescription, 2> instanceAttributes = getInstanceAttributeDescriptions(1u, 2u);
+    std::vector<VkVertexInputAttributeDescription> viads(vertexAttributes.begin(), vertexAttributes.end());
+    viads.insert(viads.end(), instanceAttributes.begin(), instanceAttributes.end());
+
+    VkPipelineVertexInputStateCreateInfo pvisci = 
+    {
+        .sType                              = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+        .pNext                              = nullptr,
+        .flags                              = 0,
+        .vertexBindingDescriptionCount      = sizeof(vibds) / sizeof(vibds[0]),
+        .pVertexBindingDescriptions         = vibds,
+        .vertexAttributeDescriptionCount    = (uint32_t) viads.size(),
+        .pVertexAttributeDescriptions       = viads.data(),
+    };
+
+    VkShaderModuleCreateInfo vertexShaderCreateInfo =
+    {
+        .sType      = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pNext      = nullptr,
+        .flags      = 0,
+        .codeSize   = m_vertexShaderCode.size(),
+        .pCode      = m_vertexShaderCode.data(),
+    };
+
+    VkShaderModule vertexShaderModule;
+    result = vkCreateShaderModule(m_device, &vertexShaderCreateInfo, nullptr, &vertexShaderModule);
+    printResult(result, "Vertex shader module module creation status");
+    
+    /* Viewport and scissor are set while recording, so the pipelines do not depend on the window size */
+    VkPipelineViewportStateCreateInfo pvsci = 
+    {
+        .sType          = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .pNext          = nullptr,
+        .flags          = 0,
+        .viewportCount  = 1u,
+        .pViewports     = nullptr,
+        .scissorCount   = 1u,
+        .pScissors      = nullptr,
+    };
+
+    VkPipelineRasterizationStateCreateInfo prsci = 
+    {
+        .sType                      = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .pNext                      = nullptr,
+        .flags                      = 0,
+        .depthClampEnable           = VK_FALSE,//VK_TRUE,
+        .rasterizerDiscardEnable    = VK_FALSE,//VK_TRUE,
+        .polygonMode                = VK_POLYGON_MODE_FILL,
+        .cullMode                   = VK_CULL_MODE_BACK_BIT,
+        .frontFace                  = VK_FRONT_FACE_CLOCKWISE,
+        .depthBiasEnable            = VK_FALSE,
+        .depthBiasConstantFactor    = 0.0f,
+        .depthBiasClamp             = 0.0f,
+        .depthBiasSlopeFactor       = 0.0f,
+        .lineWidth                  = 1.0f,
+    };
+
+    VkShaderModuleCreateInfo fragmentShaderCreateInfo =
+    {
+        .sType      = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pNext      = nullptr,
+        .flags      = 0,
+        .codeSize   = m_fragmentShaderCode.size(),
+        .pCode      = m_fragmentShaderCode.data(),
+    };
+
+    VkShaderModule fragmentShaderModule;
+    result = vkCreateShaderModule(m_device, &fragmentShaderCreateInfo, nullptr, &fragmentShaderModule);
+    printResult(result, "Fragment shader module creation result");
+
+    VkPipelineShaderStageCreateInfo shaderStagesInfo[] = 
+    {
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = vertexShaderModule,
+            .pName = "main",
+            .pSpecializationInfo = nullptr,
+        },
+        {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = fragmentShaderModule,
+            .pName = "main",
+            .pSpecializationInfo = nullptr,
+        }
+    };
+
+    VkDescriptorSetLayoutBinding dslbs[] =
+    {
+        {
+            .binding            = 0u,
+            .descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .descriptorCount    = 1u,
+            .stageFlags         = VK_SHADER_STAGE_VERTEX_BIT,
+            .pImmutableSamplers = nullptr,
+        }
+    };
+
+    VkDescriptorSetLayoutCreateInfo dslci =
+    {
+        .sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext          = nullptr,
+        .flags          = 0,
+        .bindingCount   = sizeof(dslbs) / sizeof(dslbs[0]),
+        .pBindings      = dslbs,
+    };
+
+    result = vkCreateDescriptorSetLayout(m_device, &dslci, nullptr, &m_descriptorSetLayout);
+    printResult(result, "Descriptor set layout creation result");
+
+    VkPipelineLayoutCreateInfo plci = 
+    {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .setLayoutCount         = 1u,
+        .pSetLayouts            = &m_descriptorSetLayout,
+        .pushConstantRangeCount = 0u,
+        .pPushConstantRanges    = nullptr,
+    };
+
+    result = vkCreatePipelineLayout(m_device, &plci, nullptr, &m_pipelineLayout);
+    printResult(result, "Pipeline layout creation result");
+
+    /* Test */
+    VkPipelineMultisampleStateCreateInfo pmssci = 
+    {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .rasterizationSamples   = m_sampleCount,      /* shaded once per pixel, coverage and depth per sample */
+        .sampleShadingEnable    = VK_FALSE,
+        .minSampleShading       = 1.f,
+        .pSampleMask            = nullptr,
+        .alphaToCoverageEnable  = VK_FALSE,
+        .alphaToOneEnable       = VK_FALSE,
+    };
+
+    /* After a depth pre-pass the depth buffer is final, only the nearest fragment of every pixel passes EQUAL and gets shaded */
+    VkPipelineDepthStencilStateCreateInfo pdssci = 
+    {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .depthTestEnable        = VK_TRUE,
+        .depthWriteEnable       = (VK_TRUE == m_depthPrepass) ? VK_FALSE : VK_TRUE,
+        .depthCompareOp         = (VK_TRUE == m_depthPrepass) ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS,
+        .depthBoundsTestEnable  = VK_FALSE,
+        .stencilTestEnable      = VK_FALSE,
+        .minDepthBounds         = 0.f,
+        .maxDepthBounds         = 1.f,
+    };
+
+    VkPipelineColorBlendAttachmentState pcbas = 
+    {
+        .blendEnable = VK_FALSE,
+        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    VkPipelineColorBlendStateCreateInfo pcbsci = 
+    {
+        .sType              = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .logicOpEnable      = VK_FALSE,
+        .logicOp            = VK_LOGIC_OP_CLEAR,
+        .attachmentCount    = 1,
+        .pAttachments       = &pcbas,
+        .blendConstants     = {0.f, 0.f, 0.f, 0.f},
+    };
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo pdsci =
+    {
+        .sType              = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .dynamicStateCount  = sizeof(dynamicStates) / sizeof(dynamicStates[0]),
+        .pDynamicStates     = dynamicStates,
+    };
+
+    VkGraphicsPipelineCreateInfo ci =
+    {
+        .sType                  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .stageCount             = 2u,
+        .pStages                = shaderStagesInfo,
+        .pVertexInputState      = &pvisci,
+        .pInputAssemblyState    = &piasci,
+        .pTessellationState     = nullptr,
+        .pViewportState         = &pvsci,
+        .pRasterizationState    = &prsci,
+        .pMultisampleState      = &pmssci,
+        .pDepthStencilState     = &pdssci,
+        .pColorBlendState       = &pcbsci,
+        .pDynamicState          = &pdsci,
+        .layout                 = m_pipelineLayout,
+        .renderPass             = m_renderPass,
+        .subpass                = (VK_TRUE == m_depthPrepass) ? 1u : 0u,
+        .basePipelineHandle     = VK_NULL_HANDLE,
+        .basePipelineIndex      = -1,
+    };
+
+    /* Depth pre-pass: positions and instance offsets only, no fragment shader and no color output */
+    VkVertexInputBindingDescription depthVibds[] =
+    {
+        getPositionBindingDescription<GpuVertex>(0u),
+        getInstanceBindingDescription(1u)
+    };
+
+    VkVertexInputAttributeDescription depthViads[] =
+    {
+        getPositionAttributeDescription<GpuVertex>(0u),
+        instanceAttributes[0]
+    };
+
+    VkPipelineVertexInputStateCreateInfo depthPvisci = pvisci;
+    depthPvisci.vertexBindingDescriptionCount   = sizeof(depthVibds) / sizeof(depthVibds[0]);
+    depthPvisci.pVertexBindingDescriptions      = depthVibds;
+    depthPvisci.vertexAttributeDescriptionCount = sizeof(depthViads) / sizeof(depthViads[0]);
+    depthPvisci.pVertexAttributeDescriptions    = depthViads;
+
+    VkShaderModule depthShaderModule = VK_NULL_HANDLE;
+    VkPipelineShaderStageCreateInfo depthStageInfo = shaderStagesInfo[0];
+    if (VK_TRUE == m_depthPrepass)
+    {
+        VkShaderModuleCreateInfo depthShaderCreateInfo = vertexShaderCreateInfo;
+        depthShaderCreateInfo.codeSize = m_depthShaderCode.size();
+        depthShaderCreateInfo.pCode    = m_depthShaderCode.data();
+
+        result = vkCreateShaderModule(m_device, &depthShaderCreateInfo, nullptr, &depthShaderModule);
+        printResult(result, "Depth pre-pass shader module creation result");
+        depthStageInfo.module = depthShaderModule;
+    }
+
+    VkPipelineDepthStencilStateCreateInfo depthPdssci = pdssci;
+    depthPdssci.depthWriteEnable = VK_TRUE;
+    depthPdssci.depthCompareOp   = VK_COMPARE_OP_LESS;
+
+    VkPipelineColorBlendStateCreateInfo depthPcbsci = pcbsci;
+    depthPcbsci.attachmentCount = 0u;
+    depthPcbsci.pAttachments    = nullptr;
+
+    VkGraphicsPipelineCreateInfo depthCi = ci;
+    depthCi.stageCount          = 1u;
+    depthCi.pStages             = &depthStageInfo;
+    depthCi.pVertexInputState   = &depthPvisci;
+    depthCi.pDepthStencilState  = &depthPdssci;
+    depthCi.pColorBlendState    = &depthPcbsci;
+    depthCi.subpass             = 0u;
+
+    /* Indexed by ePipeline */
+    VkGraphicsPipelineCreateInfo cis[] = {ci, depthCi};
+    uint32_t pipelineCount = (VK_TRUE == m_depthPrepass) ? 2u : 1u;
+
+    m_pipelines.resize(pipelineCount);
+    auto pipelineStart = std::chrono::steady_clock::now();
+    result = vkCreateGraphicsPipelines(m_device,
+                                       m_pipelineCache,
+                                       pipelineCount,
+                                       cis,
+                                       nullptr,
+                                       m_pipelines.data());
+    std::chrono::duration<double, std::milli> pipelineTime = std::chrono::steady_clock::now() - pipelineStart;
+
+    /* The driver does not report hits, a seeded cache that was accepted is what makes creation fast */
+    std::cout << "Pipeline creation " << pipelineTime.count() << " ms, pipeline cache "
+              << ((VK_TRUE == m_pipelineCacheSeeded) ? "hit" : "miss") << std::endl;
+    printResult(result, "Graphics pipeline creation result");
+
+    vkDestroyShaderModule(m_device, vertexShaderModule, nullptr);
+    vkDestroyShaderModule(m_device, fragmentShaderModule, nullptr);
+    if (VK_NULL_HANDLE != depthShaderModule)
+    {
+        vkDestroyShaderModule(m_device, depthShaderModule, nullptr);
+    }
+}
+
+void Example::setDepthPrepass(VkBool32 depthPrepass)
+{
+    m_depthPrepass = depthPrepass;
+}
+
+void Example::setGpuCulling(VkBool32 gpuCulling)
+{
+    m_gpuCulling = gpuCulling;
+}
+
+void Example::createCullingPipeline(void)
+{
+    VkResult result;
+
+    VkDescriptorSetLayoutBinding dslbs[] =
+    {
+        /* Source instances, compacted visible instances, indirect draw command */
+        {
+            .binding            = 0u,
+            .descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount    = 1u,
+            .stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        {
+            .binding            = 1u,
+            .descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount    = 1u,
+            .stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        },
+        {
+            .binding            = 2u,
+            .descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount    = 1u,
+            .stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT,
+            .pImmutableSamplers = nullptr,
+        }
+    };
+
+    VkDescriptorSetLayoutCreateInfo dslci =
+    {
+        .sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext          = nullptr,
+        .flags          = 0,
+        .bindingCount   = sizeof(dslbs) / sizeof(dslbs[0]),
+        .pBindings      = dslbs,
+    };
+
+    result = vkCreateDescriptorSetLayout(m_device, &dslci, nullptr, &m_cullDescriptorSetLayout);
+    printResult(result, "Culling descriptor set layout creation result");
+
+    VkPushConstantRange pushConstantRange =
+    {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0u,
+        .size       = sizeof(CullingConstants),
+    };
+
+    VkPipelineLayoutCreateInfo plci =
+    {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .setLayoutCount         = 1u,
+        .pSetLayouts            = &m_cullDescriptorSetLayout,
+        .pushConstantRangeCount = 1u,
+        .pPushConstantRanges    = &pushConstantRange,
+    };
+
+    result = vkCreatePipelineLayout(m_device, &plci, nullptr, &m_cullPipelineLayout);
+    printResult(result, "Culling pipeline layout creation result");
+
+    VkShaderModuleCreateInfo smci =
+    {
+        .sType      = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pNext      = nullptr,
+        .flags      = 0,
+        .codeSize   = m_cullShaderCode.size(),
+        .pCode      = m_cullShaderCode.data(),
+    };
+
+    VkShaderModule cullShaderModule;
+    result = vkCreateShaderModule(m_device, &smci, nullptr, &cullShaderModule);
+    printResult(result, "Culling shader module creation result");
+
+    VkComputePipelineCreateInfo cpci =
+    {
+        .sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = 0,
+        .stage              =
+        {
+            .sType                  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext                  = nullptr,
+            .flags                  = 0,
+            .stage                  = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module                 = cullShaderModule,
+            .pName                  = "main",
+            .pSpecializationInfo    = nullptr,
+        },
+        .layout             = m_cullPipelineLayout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex  = -1,
+    };
+
+    result = vkCreateComputePipelines(m_device, m_pipelineCache, 1u, &cpci, nullptr, &m_cullPipeline);
+    printResult(result, "Culling pipeline creation result");
+
+    vkDestroyShaderModule(m_device, cullShaderModule, nullptr);
+}
+
+void Example::createCullingBuffers(void)
+{
+    VkResult result;
+    uint32_t count = m_maxInflightSubmissions;
+
+    /* Per frame in flight like the instance buffers they are filled from */
+    m_visibleInstanceBuffers.resize(count);
+    m_visibleInstanceBuffersMemory.resize(count);
+    m_indirectBuffers.resize(count);
+    m_indirectBuffersMemory.resize(count);
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        createBuffer(m_instanceCount * sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_visibleInstanceBuffers[i], m_visibleInstanceBuffersMemory[i]);
+        createBuffer(sizeof(VkDrawIndexedIndirectCommand),
+                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_indirectBuffers[i], m_indirectBuffersMemory[i]);
+    }
+
+    VkDescriptorPoolSize poolSizes[] =
+    {
+        {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, .descriptorCount = 3u * count}
+    };
+
+    VkDescriptorPoolCreateInfo dpci =
+    {
+        .sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext          = nullptr,
+        .flags          = 0,
+        .maxSets        = count,
+        .poolSizeCount  = sizeof(poolSizes) / sizeof(poolSizes[0]),
+        .pPoolSizes     = poolSizes,
+    };
+
+    result = vkCreateDescriptorPool(m_device, &dpci, nullptr, &m_cullDescriptorPool);
+    printResult(result, "Culling descriptor pool creation result");
+
+    std::vector<VkDescriptorSetLayout> layouts(count, m_cullDescriptorSetLayout);
+    VkDescriptorSetAllocateInfo dsai =
+    {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext              = nullptr,
+        .descriptorPool     = m_cullDescriptorPool,
+        .descriptorSetCount = count,
+        .pSetLayouts        = layouts.data(),
+    };
+
+    m_cullDescriptorSets.resize(count);
+    result = vkAllocateDescriptorSets(m_device, &dsai, m_cullDescriptorSets.data());
+    printResult(result, "Culling descriptor sets allocation result");
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        VkDescriptorBufferInfo dbis[] =
+        {
+            {.buffer = m_instanceBuffers[i],        .offset = 0u, .range = VK_WHOLE_SIZE},
+            {.buffer = m_visibleInstanceBuffers[i], .offset = 0u, .range = VK_WHOLE_SIZE},
+            {.buffer = m_indirectBuffers[i],        .offset = 0u, .range = VK_WHOLE_SIZE},
+        };
+
+        VkWriteDescriptorSet wds =
+        {
+            .sType              = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext              = nullptr,
+            .dstSet             = m_cullDescriptorSets[i],
+            .dstBinding         = 0u,
+            .dstArrayElement    = 0u,
+            .descriptorCount    = sizeof(dbis) / sizeof(dbis[0]),
+            .descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pImageInfo         = nullptr,
+            .pBufferInfo        = dbis,
+            .pTexelBufferView   = nullptr,
+        };
+
+        vkUpdateDescriptorSets(m_device, 1u, &wds, 0u, nullptr);
+    }
+}
+
+void Example::recordCullingReset(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+    /* Start from an empty draw, the shader appends the survivors */
+    VkDrawIndexedIndirectCommand drawCommand =
+    {
+        .indexCount     = m_indexCount,
+        .instanceCount  = 0u,
+        .firstIndex     = 0u,
+        .vertexOffset   = 0,
+        .firstInstance  = 0u,
+    };
+    vkCmdUpdateBuffer(commandBuffer, m_indirectBuffers[frame], 0u, sizeof(drawCommand), &drawCommand);
+}
+
+/* Barriers around the dispatch come from the frame graph */
+void Example::recordCulling(VkCommandBuffer commandBuffer, uint32_t frame)
+{
+    /* Gribb/Hartmann: the frustum planes are sums of the matrix rows, Vulkan clip space has 0 <= z <= w */
+    glm::vec4 rows[4u];
+    for (uint32_t r = 0u; r < 4u; r++)
+    {
+        rows[r] = glm::vec4(m_mvp[0][r], m_mvp[1][r], m_mvp[2][r], m_mvp[3][r]);
+    }
+
+    CullingConstants constants;
+    constants.planes[0] = rows[3] + rows[0];
+    constants.planes[1] = rows[3] - rows[0];
+    constants.planes[2] = rows[3] + rows[1];
+    constants.planes[3] = rows[3] - rows[1];
+    constants.planes[4] = rows[2];
+    constants.planes[5] = rows[3] - rows[2];
+    for (auto & plane : constants.planes)
+    {
+        float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+        plane = plane * ((length > 0.f) ? (1.f / length) : 0.f);
+    }
+    constants.sphere = m_boundingSphere;
+    constants.instanceCount = m_instanceCount;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipelineLayout, 0u, 1u, &m_cullDescriptorSets[frame], 0u, nullptr);
+    vkCmdPushConstants(commandBuffer, m_cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0u, sizeof(constants), &constants);
+    vkCmdDispatch(commandBuffer, (m_instanceCount + 63u) / 64u, 1u, 1u);
+}
+
+void Example::createUniformBuffers(void)
+{
+    VkResult result;
+    uint32_t count = m_maxInflightSubmissions;
+
+    /* One uniform buffer per frame in flight, the frame's fence guarantees the GPU is done reading it */
+    m_uniformBuffers.resize(count);
+    m_uniformBuffersMemory.resize(count);
+    m_uniformBuffersMapped.resize(count);
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        createBuffer(sizeof(UniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     m_uniformBuffers[i], m_uniformBuffersMemory[i]);
+
+        /* Stays mapped for the whole lifetime, updated every frame */
+        m_uniformBuffersMapped[i] = m_uniformBuffersMemory[i].mapped;
+    }
+
+    VkDescriptorPoolSize poolSizes[] =
+    {
+        {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = count}
+    };
+
+    VkDescriptorPoolCreateInfo dpci =
+    {
+        .sType          = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext          = nullptr,
+        .flags          = 0,
+        .maxSets        = count,
+        .poolSizeCount  = sizeof(poolSizes) / sizeof(poolSizes[0]),
+        .pPoolSizes     = poolSizes,
+    };
+
+    result = vkCreateDescriptorPool(m_device, &dpci, nullptr, &m_descriptorPool);
+    printResult(result, "Descriptor pool creation result");
+
+    std::vector<VkDescriptorSetLayout> layouts(count, m_descriptorSetLayout);
+    VkDescriptorSetAllocateInfo dsai =
+    {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext              = nullptr,
+        .descriptorPool     = m_descriptorPool,
+        .descriptorSetCount = count,
+        .pSetLayouts        = layouts.data(),
+    };
+
+    m_descriptorSets.resize(count);
+    result = vkAllocateDescriptorSets(m_device, &dsai, m_descriptorSets.data());
+    printResult(result, "Descriptor sets allocation result");
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        VkDescriptorBufferInfo dbi =
+        {
+            .buffer = m_uniformBuffers[i],
+            .offset = 0u,
+            .range  = sizeof(UniformBufferObject),
+        };
+
+        VkWriteDescriptorSet wds =
+        {
+            .sType              = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext              = nullptr,
+            .dstSet             = m_descriptorSets[i],
+            .dstBinding         = 0u,
+            .dstArrayElement    = 0u,
+            .descriptorCount    = 1u,
+            .descriptorType     = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .pImageInfo         = nullptr,
+            .pBufferInfo        = &dbi,
+            .pTexelBufferView   = nullptr,
+        };
+
+        vkUpdateDescriptorSets(m_device, 1u, &wds, 0u, nullptr);
+    }
+
+    m_startTime = std::chrono::steady_clock::now();
+}
+
+void Example::updateUniformBuffer(uint32_t index)
+{
+    /* Spin the cube around its vertical axis, 45 degrees per second */
+    std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - m_startTime;
+
+    UniformBufferObject ubo;
+    float aspect = (float) m_extent.width / (float) m_extent.height;
+    ubo.mvp = camera(0.f, glm::vec2(45.0f * elapsed.count(), 0.f), aspect) * glm::scale(glm::mat4(1.0f), glm::vec3(m_positionScale));
+
+    memcpy(m_uniformBuffersMapped[index], &ubo, sizeof(ubo));
+    m_mvp = ubo.mvp;
+}
+
+void Example::setInstanceCount(uint32_t count)
+{
+    /* Instance buffers and command buffers are sized for this count, set it before creating them */
+    m_instanceCount = (0u == count) ? 1u : count;
+    m_instances.resize(m_instanceCount, {{0.f, 0.f, 0.f, 1.f}, {1.f, 1.f, 1.f, 1.f}});
+    m_instancesVersion++;
+}
+
+void Example::setInstanceData(uint32_t firstInstance, uint32_t count, const InstanceData * data)
+{
+    if ((firstInstance + count) > m_instanceCount)
+    {
+        throw std::runtime_error("Instance data out of range!");
+    }
+
+    /* Copied into each frame's instance buffer the next time that frame is drawn */
+    memcpy(&m_instances[firstInstance], data, count * sizeof(InstanceData));
+    m_instancesVersion++;
+}
+
+void Example::createGridScene(uint32_t count)
+{
+    /* Stress scene, count cubes in a square grid covering the area of the original cube */
+    uint32_t side = (uint32_t) ceilf(sqrtf((float) count));
+    float cell = 1.f / side;
+    std::vector<InstanceData> grid(count);
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        uint32_t column = i % side;
+        uint32_t row = i / side;
+        float u = (column + 0.5f) * cell;
+        float v = (row + 0.5f) * cell;
+
+        grid[i].offsetScale = glm::vec4(u - 0.5f, v - 0.5f, 0.f, 0.8f * cell);
+        grid[i].color = glm::vec4(0.5f + 0.5f * u, 0.5f + 0.5f * v, 1.f, 1.f);
+    }
+
+    setInstanceCount(count);
+    setInstanceData(0u, count, grid.data());
+
+    std::cout << "Grid scene: " << std::dec << count << " instances (" << side << "x" << side << ")" << std::endl;
+}
+
+void Example::createInstanceBuffers(void)
+{
+    uint32_t count = m_maxInflightSubmissions;
+    VkDeviceSize size = m_instanceCount * sizeof(InstanceData);
+
+    /* One instance buffer per frame in flight like the uniform buffers, the CPU may rewrite it every frame */
+    m_instanceBuffers.resize(count);
+    m_instanceBuffersMemory.resize(count);
+    m_instanceBuffersVersion.assign(count, m_instancesVersion - 1u);
+
+    for (uint32_t i = 0u; i < count; i++)
+    {
+        createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                     m_instanceBuffers[i], m_instanceBuffersMemory[i]);
+        updateInstanceBuffer(i);
+    }
+}
+
+void Example::updateInstanceBuffer(uint32_t index)
+{
+    /* Only copy when the instance data changed since this buffer was last written */
+    if (m_instanceBuffersVersion[index] != m_instancesVersion)
+    {
+        memcpy(m_instanceBuffersMemory[index].mapped, m_instances.data(), m_instanceCount * sizeof(InstanceData));
+        m_instanceBuffersVersion[index] = m_instancesVersion;
+    }
+}
+
+void Example::createUploadService(void)
+{
+    m_uploader.init(m_available_devices[m_selected_device], m_device, m_allocator, m_transferQueue, m_transfer_queue_idx, m_graphics_queue_idx);
+}
+
+void Example::setRecordingThreads(uint32_t threadCount)
+{
+    m_recordingThreads = threadCount;
+}
+
+void Example::setInstancesPerDraw(uint32_t instancesPerDraw)
+{
+    m_instancesPerDraw = instancesPerDraw;
+}
+
+void Example::createCommandBuffers(void)
+{
+    VkResult result;
+
+    /* Split the instances into draw calls, 0 instances per draw means a single instanced draw; GPU culling always issues one indirect draw */
+    uint32_t instancesPerDraw = ((0u == m_instancesPerDraw) || (VK_TRUE == m_gpuCulling)) ? m_instanceCount : m_instancesPerDraw;
+    m_drawList.clear();
+    for (uint32_t first = 0u; first < m_instanceCount; first += instancesPerDraw)
+    {
+        m_drawList.push_back({first, std::min(instancesPerDraw, m_instanceCount - first)});
+    }
+
+    m_threadPool.init(m_recordingThreads);
+    uint32_t threadCount = m_threadPool.getThreadCount();
+
+    /* Pools are reset as a whole once the frame's fence is signaled, so no per buffer reset flag is needed */
+    VkCommandPoolCreateInfo cpci = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = NULL,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = m_graphics_queue_idx,
+    };
+
+    /* Each frame in flight has a primary pool and one pool per recording thread, pools are not thread safe */
+    m_frameCommands.resize(m_maxInflightSubmissions);
+    for (auto & frame : m_frameCommands)
+    {
+        result = vkCreateCommandPool(m_device, &cpci, NULL, &frame.primaryPool);
+        printResult(result, "Primary command pool creation result");
+
+        VkCommandBufferAllocateInfo cbai = {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext              = NULL,
+            .commandPool        = frame.primaryPool,
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1u,
+        };
+        result = vkAllocateCommandBuffers(m_device, &cbai, &frame.primary);
+        printResult(result, "Primary command buffer allocation result");
+
+        frame.threadPools.resize(threadCount);
+        frame.secondaries.resize(threadCount);
+        for (uint32_t t = 0u; t < threadCount; t++)
+        {
+            vkCreateCommandPool(m_device, &cpci, NULL, &frame.threadPools[t]);
+
+            cbai.commandPool = frame.threadPools[t];
+            cbai.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            vkAllocateCommandBuffers(m_device, &cbai, &frame.secondaries[t]);
+        }
+
+        /* The pre-pass slices come from the same per-thread pools, the thread records both subpasses of its slice */
+        if (VK_TRUE == m_depthPrepass)
+        {
+            frame.depthSecondaries.resize(threadCount);
+            for (uint32_t t = 0u; t < threadCount; t++)
+            {
+                cbai.commandPool = frame.threadPools[t];
+                vkAllocateCommandBuffers(m_device, &cbai, &frame.depthSecondaries[t]);
+            }
+        }
+    }
+
+    std::cout << std::dec << "Recording " << m_drawList.size() << " draws per frame on " << threadCount << " threads" << std::endl;
+
+    if (VK_TRUE == m_profilingEnabled)
+    {
+        m_profiler.init(m_available_devices[m_selected_device], m_device, m_timestampValidBits, m_maxInflightSubmissions,
+                        VK_TRUE == m_pipelineStatisticsEnabled, m_profileOutputPath);
+    }
+}
+
+void Example::setProfiling(const std::string & outputPath, VkBool32 pipelineStatistics)
+{
+    /* Must be set before createDevice(), pipeline statistics need device features */
+    m_profilingEnabled = VK_TRUE;
+    m_profileOutputPath = outputPath;
+    m_pipelineStatisticsEnabled = pipelineStatistics;
+}
+
+void Example::finishProfiling(void)
+{
+    if (VK_FALSE == m_profilingEnabled)
+    {
+        return;
+    }
+
+    /* Called after the device is idle, every submitted frame has its results */
+    for (uint32_t i = 0u; i < m_maxInflightSubmissions; i++)
+    {
+        m_profiler.resolve((m_submissionNumber + i) % m_maxInflightSubmissions);
+    }
+    m_profiler.printSummary();
+    m_profiler.exportRecords();
+}
+
+void Example::recordSecondaryCommandBuffer(uint32_t frame, uint32_t imageIndex, uint32_t slice, uint32_t firstDraw, uint32_t drawCount)
+{
+    vkResetCommandPool(m_device, m_frameCommands[frame].threadPools[slice], 0);
+
+    VkCommandBufferInheritanceInfo cbii = {
+        .sType                  = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext                  = NULL,
+        .renderPass             = m_renderPass,
+        .subpass                = 0u,
+        .framebuffer            = m_framebuffers[imageIndex * m_maxInflightSubmissions + frame],
+        .occlusionQueryEnable   = VK_FALSE,
+        .queryFlags             = 0,
+        .pipelineStatistics     = m_profiler.getPipelineStatisticsFlags(),  /* the statistics query stays active across vkCmdExecuteCommands */
+    };
+
+    VkCommandBufferBeginInfo cbbi = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &cbii,
+    };
+
+    /* The same draws are recorded for the depth pre-pass (subpass 0) and the color pass, only pipeline and vertex stream differ */
+    VkDeviceSize offsets[] = {0u, 0u};
+    VkViewport viewport = {.x = 0.f, .y = 0.f, .width = (float) m_extent.width, .height = (float) m_extent.height, .minDepth = 0.f, .maxDepth = 1.f};
+    VkRect2D scissor = {.offset = {0, 0}, .extent = m_extent};
+    VkBuffer instanceBuffer = (VK_TRUE == m_gpuCulling) ? m_visibleInstanceBuffers[frame] : m_instanceBuffers[frame];
+    uint32_t passCount = (VK_TRUE == m_depthPrepass) ? 2u : 1u;
+
+    for (uint32_t pass = 0u; pass < passCount; pass++)
+    {
+        bool depthPass = (VK_TRUE == m_depthPrepass) && (0u == pass);
+        VkCommandBuffer commandBuffer = depthPass ? m_frameCommands[frame].depthSecondaries[slice] : m_frameCommands[frame].secondaries[slice];
+        VkBuffer vertexBuffers[] = {depthPass ? m_positionBuffer : m_modelBuffer, instanceBuffer};
+        cbii.subpass = pass;
+
+        /* Secondary command buffers inherit no state, every slice binds everything itself */
+        vkBeginCommandBuffer(commandBuffer, &cbbi);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[depthPass ? PIPELINE_DEPTH_PREPASS : PIPELINE_COLOR]);
+        vkCmdSetViewport(commandBuffer, 0u, 1u, &viewport);
+        vkCmdSetScissor(commandBuffer, 0u, 1u, &scissor);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0u, 1u, &m_descriptorSets[frame], 0u, nullptr);
+        vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0u, m_indexType);
+
+        if (VK_TRUE == m_gpuCulling)
+        {
+            /* Instance count comes from the culling shader, recording cost does not depend on the scene size */
+            vkCmdDrawIndexedIndirect(commandBuffer, m_indirectBuffers[frame], 0u, 1u, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            for (uint32_t i = firstDraw; i < (firstDraw + drawCount); i++)
+            {
+                vkCmdDrawIndexed(commandBuffer, m_indexCount, m_drawList[i].instanceCount, 0u, 0, m_drawList[i].firstInstance);
+            }
+        }
+
+        vkEndCommandBuffer(commandBuffer);
+    }
+}
+
+void Example::recordCommandBuffers(uint32_t frame, uint32_t imageIndex)
+{
+    ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_RECORD));
+    auto start = std::chrono::steady_clock::now();
+    FrameCommands & commands = m_frameCommands[frame];
+
+    /* Record slices of the draw list in parallel, one secondary command buffer per slice */
+    uint32_t drawCount = (uint32_t) m_drawList.size();
+    uint32_t sliceCount = std::min((uint32_t) commands.secondaries.size(), drawCount);
+    uint32_t drawsPerSlice = (drawCount + sliceCount - 1u) / sliceCount;
+    commands.sliceCount = sliceCount;
+
+    m_threadPool.parallelFor(sliceCount, [&](uint32_t slice)
+    {
+        uint32_t firstDraw = slice * drawsPerSlice;
+        uint32_t sliceDraws = std::min(drawsPerSlice, drawCount - std::min(firstDraw, drawCount));
+        recordSecondaryCommandBuffer(frame, imageIndex, slice, firstDraw, sliceDraws);
+    });
+
+    vkResetCommandPool(m_device, commands.primaryPool, 0);
+
+    VkCommandBufferBeginInfo cbbi = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = NULL,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = NULL,
+    };
+
+    vkBeginCommandBuffer(commands.primary, &cbbi);
+
+    /* Buffers uploaded since the last frame are taken over from the transfer queue before the render pass */
+    commands.waitSemaphores.clear();
+    commands.waitStages.clear();
+    m_uploader.acquire(commands.primary, m_drawFences[frame], commands.waitSemaphores, commands.waitStages);
+
+    /* Culling, the render pass and every barrier between them, as compiled in createFrameGraph() */
+    m_frameGraph.bindImage(m_targetResource, m_swapchainImages[imageIndex]);
+
+    m_profiler.cmdBegin(commands.primary, frame);
+    m_frameGraph.execute(commands.primary, {frame, imageIndex});
+    m_profiler.cmdEnd(commands.primary, frame);
+    vkEndCommandBuffer(commands.primary);
+
+    m_recordingTime += std::chrono::steady_clock::now() - start;
+    m_recordedFrames++;
+}
+
+void Example::printRecordingStatistics(void)
+{
+    if (0u != m_recordedFrames)
+    {
+        std::cout << std::dec << "Command recording: " << (m_recordingTime.count() * 1000.0 / m_recordedFrames) << " ms/frame, "
+                  << m_drawList.size() << " draws on " << m_threadPool.getThreadCount() << " threads" << std::endl;
+    }
+}
+
+void Example::createSemaphores(void)
+{
+    VkSemaphoreCreateInfo sci =
+    {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+    };
+    
+    /* Indexed by the frame in flight, not by the swapchain image */
+    m_imageReadySemaphores.resize(m_maxInflightSubmissions);
+    for (uint32_t i = 0u; i < m_maxInflightSubmissions; i++)
+    {
+        vkCreateSemaphore(m_device, &sci, nullptr, &m_imageReadySemaphores[i]);
+    }
+
+    createRenderDoneSemaphores();
+}
+
+void Example::createRenderDoneSemaphores(void)
+{
+    VkSemaphoreCreateInfo sci =
+    {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+    };
+
+    /*
+     * Indexed by the swapchain image: the present releases it at an unknown time, but the image can only be
+     * acquired again after that present consumed the semaphore
+     */
+    m_renderDoneSemaphores.resize(m_swapchainImages.size());
+    for (uint32_t i = 0u; i < m_swapchainImages.size(); i++)
+    {
+        vkCreateSemaphore(m_device, &sci, nullptr, &m_renderDoneSemaphores[i]);
+    }
+}
+
+void Example::createFences(void)
+{
+    VkFenceCreateInfo fci = 
+    {
+        .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+    };
+
+    m_drawFences.resize(m_maxInflightSubmissions);
+    for (uint32_t i = 0u; i < m_maxInflightSubmissions; i++)
+    {
+        vkCreateFence(m_device, &fci, nullptr, &m_drawFences[i]);
+    }
+
+    /* No image has been rendered yet */
+    m_imageFences.assign(m_swapchainImages.size(), VK_NULL_HANDLE);
+}
+
+void Example::invalidateSwapchain(void)
+{
+    m_swapchainOutdated = VK_TRUE;
+}
+
+void Example::recreateSwapchain(void)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    /*
+     * No vkDeviceWaitIdle: frames in flight keep rendering into and presenting the old images. Everything sized
+     * by the old swapchain is parked until their fences signaled, the new swapchain takes over its images.
+     */
+    RetiredSwapchain retired;
+    retired.swapchain = m_swapchain;
+    retired.imageViews.swap(m_swapchainImageViews);
+    retired.framebuffers.swap(m_framebuffers);
+    retired.renderDoneSemaphores.swap(m_renderDoneSemaphores);
+    retired.retiredAt = m_frameNumber;
+
+    /* Render pass and pipelines only depend on the formats, viewport and scissor are dynamic state */
+    createSwapchain();
+    createImageViews();
+
+    /* The graph's barriers and subpass dependencies stay, only its screen sized images are replaced */
+    m_frameGraph.setImageExtent(m_depthResource, m_extent);
+    if (FRAME_GRAPH_NONE != m_colorResource)
+    {
+        m_frameGraph.setImageExtent(m_colorResource, m_extent);
+    }
+    m_frameGraph.reallocate(retired.transientImages, retired.transientImageViews, retired.transientMemory);
+    m_retiredSwapchains.push_back(std::move(retired));
+
+    createFramebuffers();
+    createRenderDoneSemaphores();
+    m_imageFences.assign(m_swapchainImages.size(), VK_NULL_HANDLE);
+    m_swapchainOutdated = VK_FALSE;
+
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    std::cout << "Swapchain recreation " << duration.count() << " ms" << std::endl;
+}
+
+void Example::destroyRetiredSwapchains(VkBool32 all)
+{
+    /*
+     * Called after the fence wait of frame m_frameNumber, which guarantees that frame m_frameNumber - frames in flight
+     * and all frames before it are done; the old swapchain was used by frames up to retiredAt - 1
+     */
+    while (!m_retiredSwapchains.empty())
+    {
+        RetiredSwapchain & retired = m_retiredSwapchains.front();
+        if ((VK_FALSE == all) && ((m_frameNumber + 1u) < (retired.retiredAt + m_maxInflightSubmissions)))
+        {
+            break;
+        }
+
+        for (auto semaphore : retired.renderDoneSemaphores)
+        {
+            vkDestroySemaphore(m_device, semaphore, nullptr);
+        }
+        for (auto framebuffer : retired.framebuffers)
+        {
+            vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+        }
+        for (auto imageView : retired.transientImageViews)
+        {
+            vkDestroyImageView(m_device, imageView, nullptr);
+        }
+        for (auto image : retired.transientImages)
+        {
+            vkDestroyImage(m_device, image, nullptr);
+        }
+        for (auto & memory : retired.transientMemory)
+        {
+            m_allocator.free(memory);
+        }
+        for (auto imageView : retired.imageViews)
+        {
+            vkDestroyImageView(m_device, imageView, nullptr);
+        }
+        vkDestroySwapchainKHR(m_device, retired.swapchain, nullptr);
+        m_retiredSwapchains.pop_front();
+    }
+}
+
+void Example::drawFrame(void)
+{
+    VkResult result;
+    uint32_t imageIndex;
+    uint32_t frame = m_submissionNumber;
+
+    /* Blocks only when the CPU is m_maxInflightSubmissions frames ahead of the GPU */
+    m_profiler.beginFrame();
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_FENCE_WAIT));
+        vkWaitForFences(m_device, 1, &m_drawFences[frame], VK_TRUE, UINT64_MAX);
+    }
+
+    /* The previous use of this frame slot has finished on the GPU, its queries can be read without waiting */
+    m_profiler.resolve(frame);
+    destroyRetiredSwapchains(VK_FALSE);
+
+    if (VK_TRUE == m_swapchainOutdated)
+    {
+        recreateSwapchain();
+    }
+
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_ACQUIRE));
+        result = vkAcquireNextImageKHR(m_device, m_swapchain, UINT64_MAX, m_imageReadySemaphores[frame], VK_NULL_HANDLE, &imageIndex);
+    }
+
+    /* The fence stays signaled when nothing is submitted, so the next wait on this slot cannot dead lock */
+    if (VK_ERROR_OUT_OF_DATE_KHR == result)
+    {
+        m_swapchainOutdated = VK_TRUE;
+        return;
+    }
+    if ((VK_SUCCESS != result) && (VK_SUBOPTIMAL_KHR != result))
+    {
+        return;
+    }
+
+    /* Images may be returned out of order, wait until an older frame still rendering into this image is done */
+    if ((VK_NULL_HANDLE != m_imageFences[imageIndex]) && (m_drawFences[frame] != m_imageFences[imageIndex]))
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_FENCE_WAIT));
+        vkWaitForFences(m_device, 1, &m_imageFences[imageIndex], VK_TRUE, UINT64_MAX);
+    }
+    m_imageFences[imageIndex] = m_drawFences[frame];
+    vkResetFences(m_device, 1, &m_drawFences[frame]);
+
+    updateUniformBuffer(frame);
+    updateInstanceBuffer(frame);
+    recordCommandBuffers(frame, imageIndex);
+
+    FrameCommands & commands = m_frameCommands[frame];
+    commands.waitSemaphores.push_back(m_imageReadySemaphores[frame]);
+    commands.waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+    /* Queue all rendering commands and transition the image layout  */
+    VkSubmitInfo submitInfo = {
+        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext              = NULL,
+        .waitSemaphoreCount = (uint32_t) commands.waitSemaphores.size(),
+        .pWaitSemaphores    = commands.waitSemaphores.data(),
+        .pWaitDstStageMask  = commands.waitStages.data(),
+        .commandBufferCount = 1u,
+        .pCommandBuffers    = &commands.primary,
+        .signalSemaphoreCount = 1u,
+        .pSignalSemaphores  = &m_renderDoneSemaphores[imageIndex],
+    };
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_SUBMIT));
+        vkQueueSubmit(m_graphicsQueue, 1u, &submitInfo, m_drawFences[frame]);
+    }
+
+    m_submissionNumber = (m_submissionNumber + 1u) % m_maxInflightSubmissions;
+    m_frameNumber++;
+
+    /* Queue the image for presentation */
+    VkPresentInfoKHR presentInfo = {
+        .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+        .pNext              = NULL,
+        .waitSemaphoreCount = 1u,
+        .pWaitSemaphores    = &m_renderDoneSemaphores[imageIndex],
+        .swapchainCount     = 1u,
+        .pSwapchains        = &m_swapchain,
+        .pImageIndices      = &imageIndex,
+        .pResults           = NULL,
+    };
+
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_PRESENT));
+        result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+    }
+
+    /* A suboptimal image was still presented, the swapchain is replaced before the next acquire */
+    if ((VK_ERROR_OUT_OF_DATE_KHR == result) || (VK_SUBOPTIMAL_KHR == result))
+    {
+        m_swapchainOutdated = VK_TRUE;
+    }
+
+    m_profiler.endFrame(frame);
+}
+
+void Example::drawOffscreenFrame(void)
+{
+    uint32_t frame = m_submissionNumber;
+
+    m_profiler.beginFrame();
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_FENCE_WAIT));
+        vkWaitForFences(m_device, 1, &m_drawFences[frame], VK_TRUE, UINT64_MAX);
+    }
+    vkResetFences(m_device, 1, &m_drawFences[frame]);
+    m_profiler.resolve(frame);
+
+    updateUniformBuffer(frame);
+    updateInstanceBuffer(frame);
+    recordCommandBuffers(frame, frame);
+
+    /* Each frame in flight owns its own offscreen target, only pending uploads are waited for */
+    FrameCommands & commands = m_frameCommands[frame];
+    VkSubmitInfo submitInfo = {
+        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext              = NULL,
+        .waitSemaphoreCount = (uint32_t) commands.waitSemaphores.size(),
+        .pWaitSemaphores    = commands.waitSemaphores.data(),
+        .pWaitDstStageMask  = commands.waitStages.data(),
+        .commandBufferCount = 1u,
+        .pCommandBuffers    = &commands.primary,
+        .signalSemaphoreCount = 0u,
+        .pSignalSemaphores  = NULL,
+    };
+    {
+        ScopedTimer timer(m_profiler.cpuTime(CPU_TIMER_SUBMIT));
+        vkQueueSubmit(m_graphicsQueue, 1u, &submitInfo, m_drawFences[frame]);
+    }
+
+    m_submissionNumber = (m_submissionNumber + 1u) % m_maxInflightSubmissions;
+    m_frameNumber++;
+
+    m_profiler.endFrame(frame);
+}
+
+void Example::cleanup(void)
+{
+    m_uploader.destroy();
+    for (auto & frame : m_frameCommands)
+    {
+        for (auto pool : frame.threadPools)
+        {
+            vkDestroyCommandPool(m_device, pool, nullptr);
+        }
+        vkDestroyCommandPool(m_device, frame.primaryPool, nullptr);
+    }
+    m_threadPool.destroy();
+    m_profiler.destroy();
+
+    for (auto semaphore : m_imageReadySemaphores)
+    {
+        vkDestroySemaphore(m_device, semaphore, nullptr);
+    }
+    for (auto semaphore : m_renderDoneSemaphores)
+    {
+        vkDestroySemaphore(m_device, semaphore, nullptr);
+    }
+    for (auto fence : m_drawFences)
+    {
+        vkDestroyFence(m_device, fence, nullptr);
+    }
+
+    vkDestroyBuffer(m_device, m_modelBuffer, nullptr);
+    m_allocator.free(m_modelBufferMemory);
+    vkDestroyBuffer(m_device, m_indexBuffer, nullptr);
+    m_allocator.free(m_indexBufferMemory);
+    if (VK_TRUE == m_depthPrepass)
+    {
+        vkDestroyBuffer(m_device, m_positionBuffer, nullptr);
+        m_allocator.free(m_positionBufferMemory);
+    }
+
+    for (uint32_t i = 0u; i < m_uniformBuffers.size(); i++)
+    {
+        vkDestroyBuffer(m_device, m_uniformBuffers[i], nullptr);
+        m_allocator.free(m_uniformBuffersMemory[i]);
+    }
+    vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+
+    for (uint32_t i = 0u; i < m_instanceBuffers.size(); i++)
+    {
+        vkDestroyBuffer(m_device, m_instanceBuffers[i], nullptr);
+        m_allocator.free(m_instanceBuffersMemory[i]);
+    }
+
+    if (VK_TRUE == m_gpuCulling)
+    {
+        for (uint32_t i = 0u; i < m_visibleInstanceBuffers.size(); i++)
+        {
+            vkDestroyBuffer(m_device, m_visibleInstanceBuffers[i], nullptr);
+            m_allocator.free(m_visibleInstanceBuffersMemory[i]);
+            vkDestroyBuffer(m_device, m_indirectBuffers[i], nullptr);
+            m_allocator.free(m_indirectBuffersMemory[i]);
+        }
+        vkDestroyDescriptorPool(m_device, m_cullDescriptorPool, nullptr);
+        vkDestroyPipeline(m_device, m_cullPipeline, nullptr);
+        vkDestroyPipelineLayout(m_device, m_cullPipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(m_device, m_cullDescriptorSetLayout, nullptr);
+    }
+
+    for (auto & framebuffer : m_framebuffers)
+    {
+        vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+    }
+    for (auto imageView : m_swapchainImageViews)
+    {
+        vkDestroyImageView(m_device, imageView, nullptr);
+    }
+    if (VK_TRUE == m_headless)
+    {
+        for (uint32_t i = 0u; i < m_swapchainImages.size(); i++)
+        {
+            vkDestroyImage(m_device, m_swapchainImages[i], nullptr);
+            m_allocator.free(m_offscreenImageMemory[i]);
+        }
+    }
+    else
+    {
+        vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
+        destroyRetiredSwapchains(VK_TRUE);
+    }
+    for (auto & pipeline : m_pipelines)
+    {
+        vkDestroyPipeline(m_device, pipeline, nullptr);
+    }
+    vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+    m_vertexShaderCode.release();
+    m_fragmentShaderCode.release();
+    m_cullShaderCode.release();
+    m_depthShaderCode.release();
+    savePipelineCache();
+    vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+    vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
+    vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+    m_frameGraph.destroy();
+    m_allocator.printStatistics();
+    m_allocator.destroy();
+    vkDestroyDevice(m_device, nullptr);
+    if (VK_FALSE == m_headless)
+    {
+        vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+        glfwDestroyWindow(m_window);
+        glfwTerminate();
+    }
+    vkDestroyInstance(m_instance, nullptr);
 }
\ No newline at end of file
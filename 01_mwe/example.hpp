@@ -1,154 +1,334 @@
-#include <string>
-#include <vector>
-
-#include <vulkan/vulkan.h>
-#include "GLFW/glfw3.h"
-#include "glm/glm/vec4.hpp"
-
-#ifndef EXAMPLE_GUARD
-#define EXAMPLE_GUARD
-
-#define USE_GLM
-
-#if defined USE_GLM
-struct Vertex
-{
-    glm::vec4 coord;
-    glm::vec4 color;
-};
-#else
-struct Vertex
-{
-    struct
-    {
-        float x;
-        float y;
-        float z;
-        float w;
-    } coord;
-    struct
-    {
-        float r;
-        float g;
-        float b;
-        float a;
-    } color;
-};
-#endif
-
-#define COLOR_RED   {1.f, 0.f, 0.f, 1.f}
-#define COLOR_GREEN {0.f, 1.f, 0.f, 1.f}
-#define COLOR_BLUE  {0.f, 0.f, 1.f, 1.f}
-#define COLOR_RG    {1.f, 1.f, 0.f, 1.f}
-#define COLOR_RB    {1.f, 0.f, 1.f, 1.f}
-#define COLOR_GB    {0.f, 1.f, 1.f, 1.f}
-
-#if 0
-#define VERTEX_1    {0.f, 0.f, 0.f, 1.f}
-#define VERTEX_2    {1.f, 0.f, 0.f, 1.f}
-#define VERTEX_3    {1.f, -1.f, 0.f, 1.f}
-#define VERTEX_4    {0.f, -1.f, 0.f, 1.f}
-#define VERTEX_5    {0.f, 0.f, 1.f, 1.f}
-#define VERTEX_6    {1.f, 0.f, 1.f, 1.f}
-#define VERTEX_7    {1.f, -1.f, 1.f, 1.f}
-#define VERTEX_8    {0.f, -1.f, 1.f, 1.f}
-#else
-#define VERTEX_1    {-0.5f, 0.5f, 0.f, 1.f}
-#define VERTEX_2    {0.5f,  0.5f, 0.f, 1.f}
-#define VERTEX_3    {0.5f, -0.5f, 0.f, 1.f}
-#define VERTEX_4    {-0.5f, -0.5f, 0.f, 1.f}
-#define VERTEX_5    {-0.5f, 0.5f, 1.f, 1.f}
-#define VERTEX_6    {0.5f, 0.5f, 1.f, 1.f}
-#define VERTEX_7    {0.5f, -0.5f, 1.f, 1.f}
-#define VERTEX_8    {-0.5f, -0.5f, 1.f, 1.f}
-#endif
-
-
-typedef enum
-{
-    DOUBLE_BUFFERING,
-    TRIPPLE_BUFFERING
-} eBufferingMode;
-
-class Example
-{
-    private:
-        GLFWwindow *                        m_window;
-        VkSurfaceKHR                        m_surface;
-        VkSurfaceCapabilitiesKHR            m_surfaceCapabilities;
-        std::vector<VkSurfaceFormatKHR>     m_surfaceFormats;
-        std::vector<VkPresentModeKHR>       m_presentModes;
-    
-        VkInstance                          m_instance;
-        std::vector<VkExtensionProperties>  m_available_extensions;
-        std::vector<const char *>           m_required_validation_layers = {"VK_LAYER_KHRONOS_validation", "VK_LAYER_LUNARG_parameter_validation", "VK_LAYER_LUNARG_standard_validation"};
-
-        std::vector<const char *>           m_required_instance_extensions = {VK_KHR_SURFACE_EXTENSION_NAME, "VK_KHR_win32_surface"};
-
-        std::vector<VkPhysicalDevice>       m_available_devices;
-        std::vector<const char *>           m_requiredPhysicalDeviceExtension = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
-
-        VkDevice        m_device;
-        uint32_t        m_selected_device;
-        uint32_t        m_graphics_queue_idx;
-        uint32_t        m_present_queue_idx;
-
-        VkSwapchainKHR              m_swapchain;
-        VkBool32                    m_isDoubleBufferingSupported;
-        VkBool32                    m_isTrippleBufferingSupported;
-        eBufferingMode              m_selectedBufferingMode;
-        std::vector<VkImage>        m_swapchainImages;
-        std::vector<VkImageView>    m_swapchainImageViews;
-        VkImage                     m_depthImage;
-        VkDeviceMemory              m_depthImageMemory;
-        VkImageView                 m_depthImageView;
-
-        std::vector<VkFramebuffer>  m_framebuffers;
-
-        std::vector<VkSemaphore>    m_imageReadySemaphores;
-        VkSemaphore                 m_renderDoneSemaphore;
-        std::vector<VkFence>        m_drawFences;
-        uint32_t                    m_submissionNumber = 0u;
-        uint32_t                    m_maxInflightSubmissions = 2u;
-
-        VkBuffer        m_modelBuffer;
-        VkDeviceMemory  m_modelBufferMemory;
-
-        std::vector<VkPipeline> m_pipelines;
-        VkPipelineLayout m_pipelineLayout;
-
-        VkRenderPass m_renderPass;
-        VkAttachmentDescription m_attachmentDescription;
-        VkSubpassDescription m_subpassDescriptions;
-
-        VkCommandPool m_commandPool;
-        std::vector<VkCommandBuffer> m_commandBuffers;
-        
-    public:
-        void drawFrame(void);
-        void InitExample(void);
-
-        int32_t createWindow(void);
-
-        void run(void);
-        
-        void createInstance(void);
-        void createDevice(void);
-        void createSwapchain(void);
-        void createDepthResources(void);
-        void createImageViews(void);
-        void createRenderPass(void);
-        void createFramebuffers(void);
-        void createCommandBuffers(void);
-        void createPipeline(void);
-        void createSemaphores(void);
-        void createFences(void);
-
-        uint32_t getQueueFamilyIndex(void);
-
-        void cleanup(void);
-
-        static uint32_t getCubeSizeBytes(void);
-        static uint32_t getCubeVerticesCount(void);
-};
+#include <string>
+#include <vector>
+#include <deque>
+#include <chrono>
+
+#include <vulkan/vulkan.h>
+#include "GLFW/glfw3.h"
+#include "glm/glm/vec4.hpp"
+#include "glm/glm/mat4x4.hpp"
+#include "memory_allocator.hpp"
+#include "vertex_format.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "task_graph.hpp"
+#include "shader_code.hpp"
+#include "upload_service.hpp"
+#include "device_selection.hpp"
+#include "mesh_file.hpp"
+#include "frame_graph.hpp"
+
+#ifndef EXAMPLE_GUARD
+#define EXAMPLE_GUARD
+
+/* Per-frame shader constants, std140 layout matching shader.vert */
+struct UniformBufferObject
+{
+    glm::mat4 mvp;
+};
+
+/* Push constants of shaders/cull.comp */
+struct CullingConstants
+{
+    glm::vec4   planes[6];      /* frustum planes in the space instances are placed in, normalized */
+    glm::vec4   sphere;         /* bounding sphere of the mesh, xyz center, w radius */
+    uint32_t    instanceCount;
+};
+
+#define COLOR_RED   {1.f, 0.f, 0.f, 1.f}
+#define COLOR_GREEN {0.f, 1.f, 0.f, 1.f}
+#define COLOR_BLUE  {0.f, 0.f, 1.f, 1.f}
+#define COLOR_RG    {1.f, 1.f, 0.f, 1.f}
+#define COLOR_RB    {1.f, 0.f, 1.f, 1.f}
+#define COLOR_GB    {0.f, 1.f, 1.f, 1.f}
+
+#if 0
+#define VERTEX_1    {0.f, 0.f, 0.f, 1.f}
+#define VERTEX_2    {1.f, 0.f, 0.f, 1.f}
+#define VERTEX_3    {1.f, -1.f, 0.f, 1.f}
+#define VERTEX_4    {0.f, -1.f, 0.f, 1.f}
+#define VERTEX_5    {0.f, 0.f, 1.f, 1.f}
+#define VERTEX_6    {1.f, 0.f, 1.f, 1.f}
+#define VERTEX_7    {1.f, -1.f, 1.f, 1.f}
+#define VERTEX_8    {0.f, -1.f, 1.f, 1.f}
+#else
+#define VERTEX_1    {-0.5f, 0.5f, 0.f, 1.f}
+#define VERTEX_2    {0.5f,  0.5f, 0.f, 1.f}
+#define VERTEX_3    {0.5f, -0.5f, 0.f, 1.f}
+#define VERTEX_4    {-0.5f, -0.5f, 0.f, 1.f}
+#define VERTEX_5    {-0.5f, 0.5f, 1.f, 1.f}
+#define VERTEX_6    {0.5f, 0.5f, 1.f, 1.f}
+#define VERTEX_7    {0.5f, -0.5f, 1.f, 1.f}
+#define VERTEX_8    {-0.5f, -0.5f, 1.f, 1.f}
+#endif
+
+
+/* Range of instances drawn by one vkCmdDrawIndexed */
+struct DrawCommand
+{
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+/* Command buffers of one frame in flight, reset together once the frame's fence is signaled */
+struct FrameCommands
+{
+    VkCommandPool                   primaryPool;
+    VkCommandBuffer                 primary;
+    std::vector<VkCommandPool>      threadPools;    /* one per recording thread */
+    std::vector<VkCommandBuffer>    secondaries;
+    std::vector<VkCommandBuffer>    depthSecondaries;   /* depth pre-pass subpass, one per recording thread */
+    uint32_t                        sliceCount;         /* secondaries recorded for the current frame */
+    std::vector<VkSemaphore>        waitSemaphores;     /* filled while recording, e.g. uploads the frame has to wait for */
+    std::vector<VkPipelineStageFlags> waitStages;
+};
+
+/* Swapchain sized resources replaced by a resize, destroyed once no frame in flight uses them */
+struct RetiredSwapchain
+{
+    VkSwapchainKHR                  swapchain;
+    std::vector<VkImageView>        imageViews;
+    std::vector<VkImage>            transientImages;        /* depth and multisampled color of the frame graph */
+    std::vector<VkImageView>        transientImageViews;
+    std::vector<MemoryAllocation>   transientMemory;
+    std::vector<VkFramebuffer>      framebuffers;
+    std::vector<VkSemaphore>        renderDoneSemaphores;
+    uint64_t                        retiredAt;      /* frames submitted before the swapchain was replaced */
+};
+
+/* Index into m_pipelines */
+typedef enum
+{
+    PIPELINE_COLOR,
+    PIPELINE_DEPTH_PREPASS
+} ePipeline;
+
+typedef enum
+{
+    DOUBLE_BUFFERING,
+    TRIPPLE_BUFFERING
+} eBufferingMode;
+
+class Example
+{
+    private:
+        GLFWwindow *                        m_window;
+        VkSurfaceKHR                        m_surface;
+        VkSurfaceCapabilitiesKHR            m_surfaceCapabilities;
+        std::vector<VkSurfaceFormatKHR>     m_surfaceFormats;
+        std::vector<VkPresentModeKHR>       m_presentModes;
+        VkBool32                            m_headless = VK_FALSE;
+    
+        VkInstance                          m_instance;
+        std::vector<VkExtensionProperties>  m_available_extensions;
+        std::vector<const char *>           m_required_validation_layers = {"VK_LAYER_KHRONOS_validation", "VK_LAYER_LUNARG_parameter_validation", "VK_LAYER_LUNARG_standard_validation"};
+
+        std::vector<const char *>           m_required_instance_extensions = {VK_KHR_SURFACE_EXTENSION_NAME, "VK_KHR_win32_surface"};
+
+        std::vector<VkPhysicalDevice>       m_available_devices;
+        std::vector<const char *>           m_requiredPhysicalDeviceExtension = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+        VkDevice        m_device;
+        uint32_t        m_selected_device;
+        std::string     m_devicePreference;
+        uint32_t        m_graphics_queue_idx;
+        uint32_t        m_present_queue_idx;
+        uint32_t        m_transfer_queue_idx;
+        std::vector<VkQueueFamilyProperties> m_queueFamilyProperties;
+        VkQueue         m_graphicsQueue;
+        VkQueue         m_presentQueue;
+        VkQueue         m_transferQueue;
+        VkPhysicalDeviceMemoryProperties m_memoryProperties;
+
+        VkSwapchainKHR              m_swapchain = VK_NULL_HANDLE;
+        VkBool32                    m_swapchainOutdated = VK_FALSE;     /* resized, or the present reported out of date */
+        std::deque<RetiredSwapchain> m_retiredSwapchains;
+        VkBool32                    m_isDoubleBufferingSupported;
+        VkBool32                    m_isTrippleBufferingSupported;
+        eBufferingMode              m_selectedBufferingMode;
+        uint32_t                    m_requestedImageCount = 2u;
+        VkPresentModeKHR            m_requestedPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+        std::vector<VkImage>        m_swapchainImages;
+        std::vector<VkImageView>    m_swapchainImageViews;
+        std::vector<MemoryAllocation> m_offscreenImageMemory;
+        VkFormat                    m_colorFormat;
+        VkExtent2D                  m_extent = {640u, 480u};
+        VkFormat                    m_requestedDepthFormat = VK_FORMAT_D32_SFLOAT;
+        VkFormat                    m_depthFormat = VK_FORMAT_D32_SFLOAT;
+        uint32_t                    m_requestedSampleCount = 1u;
+        VkSampleCountFlagBits       m_sampleCount = VK_SAMPLE_COUNT_1_BIT;
+
+        std::vector<VkFramebuffer>  m_framebuffers;     /* per swapchain image and frame in flight, see createFramebuffers() */
+
+        std::vector<VkSemaphore>    m_imageReadySemaphores;     /* per frame in flight */
+        std::vector<VkSemaphore>    m_renderDoneSemaphores;     /* per swapchain image, released by the present */
+        std::vector<VkFence>        m_drawFences;               /* per frame in flight */
+        std::vector<VkFence>        m_imageFences;              /* fence of the frame that last rendered each image */
+        uint32_t                    m_submissionNumber = 0u;
+        uint64_t                    m_frameNumber = 0u;         /* frames submitted so far */
+        uint32_t                    m_maxInflightSubmissions = 2u;
+
+        DeviceMemoryAllocator m_allocator;
+
+        VkBuffer            m_modelBuffer;
+        MemoryAllocation    m_modelBufferMemory;
+        VkBuffer            m_positionBuffer;           /* position-only copy of the model for the depth pre-pass */
+        MemoryAllocation    m_positionBufferMemory;
+        VkBuffer            m_indexBuffer;
+        MemoryAllocation    m_indexBufferMemory;
+        VkIndexType         m_indexType;
+        uint32_t            m_indexCount;
+        float               m_positionScale = 1.f;
+        std::string         m_meshPath;                 /* converted mesh file, the built-in cube when empty */
+
+        uint32_t                        m_instanceCount = 1u;
+        std::vector<InstanceData>       m_instances = {{{0.f, 0.f, 0.f, 1.f}, {1.f, 1.f, 1.f, 1.f}}};
+        uint32_t                        m_instancesVersion = 0u;
+        std::vector<VkBuffer>           m_instanceBuffers;
+        std::vector<MemoryAllocation>   m_instanceBuffersMemory;
+        std::vector<uint32_t>           m_instanceBuffersVersion;
+
+        std::vector<VkBuffer>           m_uniformBuffers;
+        std::vector<MemoryAllocation>   m_uniformBuffersMemory;
+        std::vector<void *>             m_uniformBuffersMapped;
+        VkDescriptorSetLayout           m_descriptorSetLayout;
+        VkDescriptorPool                m_descriptorPool;
+        std::vector<VkDescriptorSet>    m_descriptorSets;
+        std::chrono::steady_clock::time_point m_startTime;
+        glm::mat4                       m_mvp;      /* last matrix written by updateUniformBuffer() */
+
+        VkBool32                        m_gpuCulling = VK_FALSE;
+        glm::vec4                       m_boundingSphere;
+        VkDescriptorSetLayout           m_cullDescriptorSetLayout;
+        VkPipelineLayout                m_cullPipelineLayout;
+        VkPipeline                      m_cullPipeline;
+        VkDescriptorPool                m_cullDescriptorPool;
+        std::vector<VkDescriptorSet>    m_cullDescriptorSets;
+        std::vector<VkBuffer>           m_visibleInstanceBuffers;   /* compacted survivors, per frame in flight */
+        std::vector<MemoryAllocation>   m_visibleInstanceBuffersMemory;
+        std::vector<VkBuffer>           m_indirectBuffers;          /* VkDrawIndexedIndirectCommand written by the culling shader */
+        std::vector<MemoryAllocation>   m_indirectBuffersMemory;
+
+        std::string m_shaderDirectory;
+        ShaderCode m_vertexShaderCode;
+        ShaderCode m_fragmentShaderCode;
+        ShaderCode m_cullShaderCode;
+        ShaderCode m_depthShaderCode;
+        VkBool32 m_depthPrepass = VK_FALSE;
+        std::vector<VkPipeline> m_pipelines;
+        VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+        std::string m_pipelineCachePath = "pipeline_cache.bin";
+        VkBool32 m_pipelineCacheSeeded = VK_FALSE;
+        VkPipelineLayout m_pipelineLayout;
+
+        VkRenderPass m_renderPass;
+        FrameGraph m_frameGraph;
+        uint32_t m_mainRenderPass;
+        uint32_t m_targetResource;
+        uint32_t m_colorResource = FRAME_GRAPH_NONE;   /* multisampled color owned by the graph, MSAA only */
+        uint32_t m_depthResource;                       /* owned by the graph, one per frame in flight */
+        VkAttachmentDescription m_attachmentDescription;
+        VkSubpassDescription m_subpassDescriptions;
+
+        UploadService m_uploader;
+        std::vector<FrameCommands> m_frameCommands;
+        std::vector<DrawCommand> m_drawList;
+        uint32_t m_instancesPerDraw = 0u;
+        uint32_t m_recordingThreads = 0u;
+        ThreadPool m_threadPool;
+        std::chrono::duration<double> m_recordingTime{0.0};
+        uint32_t m_recordedFrames = 0u;
+
+        FrameProfiler m_profiler;
+        VkBool32 m_profilingEnabled = VK_FALSE;
+        VkBool32 m_pipelineStatisticsEnabled = VK_FALSE;
+        std::string m_profileOutputPath;
+        uint32_t m_timestampValidBits = 0u;
+        
+    public:
+        void drawFrame(void);
+        void drawOffscreenFrame(void);
+        void InitExample(void);
+
+        int32_t createWindow(void);
+
+        void run(void);
+        void runHeadless(uint32_t frameCount);
+        void setHeadless(VkBool32 headless);
+        void setDevicePreference(const std::string & preference);
+        void waitIdle(void);
+        
+        void createInstance(void);
+        void createDevice(void);
+        void createSwapchain(void);
+        void invalidateSwapchain(void);
+        void recreateSwapchain(void);
+        void destroyRetiredSwapchains(VkBool32 all);
+        void setPresentMode(VkPresentModeKHR presentMode);
+        void setSwapchainImageCount(uint32_t imageCount);
+        void setFramesInFlight(uint32_t framesInFlight);
+        VkPresentModeKHR selectPresentMode(void);
+        void createOffscreenTargets(void);
+        void setDepthFormat(VkFormat format);
+        void selectDepthFormat(void);
+        uint32_t findTransientMemoryType(uint32_t typeBits);
+        void setSampleCount(uint32_t sampleCount);
+        void selectSampleCount(void);
+        uint32_t getSampleCount(void);
+        void createImageViews(void);
+        void createFrameGraph(void);
+        void createRenderPass(void);
+        void createFramebuffers(void);
+        void createUploadService(void);
+        void createCommandBuffers(void);
+        void setRecordingThreads(uint32_t threadCount);
+        void setInstancesPerDraw(uint32_t instancesPerDraw);
+        void recordCommandBuffers(uint32_t frame, uint32_t imageIndex);
+        void recordSecondaryCommandBuffer(uint32_t frame, uint32_t imageIndex, uint32_t slice, uint32_t firstDraw, uint32_t drawCount);
+        void printRecordingStatistics(void);
+        void setProfiling(const std::string & outputPath, VkBool32 pipelineStatistics);
+        void finishProfiling(void);
+        void buildInitGraph(TaskGraph & graph);
+        void setShaderDirectory(const std::string & directory);
+        void loadShaders(void);
+        void setMeshFile(const std::string & path);
+        void createMeshBuffers(void);
+        void loadMeshFile(void);
+        void createPositionBuffer(uint32_t vertexCount);
+        void uploadPositions(const uint8_t * vertexData, uint32_t firstVertex, uint32_t vertexCount, uint32_t vertexStride);
+        void createPipelineCache(void);
+        void savePipelineCache(void);
+        void createPipeline(void);
+        void setDepthPrepass(VkBool32 depthPrepass);
+        void setGpuCulling(VkBool32 gpuCulling);
+        void createCullingPipeline(void);
+        void createCullingBuffers(void);
+        void recordCullingReset(VkCommandBuffer commandBuffer, uint32_t frame);
+        void recordCulling(VkCommandBuffer commandBuffer, uint32_t frame);
+        void createUniformBuffers(void);
+        void updateUniformBuffer(uint32_t index);
+        void createInstanceBuffers(void);
+        void updateInstanceBuffer(uint32_t index);
+        void setInstanceCount(uint32_t count);
+        void setInstanceData(uint32_t firstInstance, uint32_t count, const InstanceData * data);
+        void createGridScene(uint32_t count);
+        void createSemaphores(void);
+        void createRenderDoneSemaphores(void);
+        void createFences(void);
+
+        uint32_t getQueueFamilyIndex(VkQueueFlags required, VkQueueFlags avoided);
+        uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+
+        void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer & buffer, MemoryAllocation & memory);
+        void uploadBuffer(const void * data, VkDeviceSize size, VkBufferUsageFlags usage, VkBuffer & buffer, MemoryAllocation & memory);
+
+        void cleanup(void);
+
+        static uint32_t getCubeSizeBytes(void);
+        static uint32_t getCubeVerticesCount(void);
+
+        /* Command line values, false for an unknown name */
+        static bool parsePresentMode(const char * name, VkPresentModeKHR & presentMode);
+        static bool parseDepthFormat(const char * name, VkFormat & format);
+};
 #endif
\ No newline at end of file
@@ -0,0 +1,866 @@
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include "frame_graph.hpp"
+
+/* Stages that work on one pixel at a time, dependencies between them can be by region */
+#define FRAMEBUFFER_STAGES  (VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | \
+                             VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+
+uint32_t FrameGraph::addResource(const std::string & name, bool image, VkImageAspectFlags aspect, const FrameGraphState & initial)
+{
+    Resource resource = {};
+    resource.name = name;
+    resource.image = image;
+    resource.transient = false;
+    resource.exported = false;
+    resource.initial = initial;
+    resource.aspect = aspect;
+    resource.bound = VK_NULL_HANDLE;
+    resource.firstPass = FRAME_GRAPH_NONE;
+    resource.lastPass = FRAME_GRAPH_NONE;
+    resource.slot = FRAME_GRAPH_NONE;
+    resource.aliasOf = FRAME_GRAPH_NONE;
+    m_resources.push_back(resource);
+    return (uint32_t) (m_resources.size() - 1u);
+}
+
+uint32_t FrameGraph::importBuffer(const std::string & name, const FrameGraphState & initial)
+{
+    return addResource(name, false, 0, initial);
+}
+
+uint32_t FrameGraph::importImage(const std::string & name, VkImageAspectFlags aspect, const FrameGraphState & initial)
+{
+    return addResource(name, true, aspect, initial);
+}
+
+uint32_t FrameGraph::createImage(const std::string & name, const VkImageCreateInfo & imageInfo, VkImageAspectFlags aspect)
+{
+    /* Contents never survive the frame, the first use starts from an undefined layout */
+    uint32_t resource = addResource(name, true, aspect, {0, 0, VK_IMAGE_LAYOUT_UNDEFINED});
+    m_resources[resource].transient = true;
+    m_resources[resource].imageInfo = imageInfo;
+    m_resources[resource].imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    return resource;
+}
+
+void FrameGraph::exportResource(uint32_t resource, const FrameGraphState & final)
+{
+    m_resources[resource].exported = true;
+    m_resources[resource].final = final;
+}
+
+uint32_t FrameGraph::addRenderPass(const std::string & name, FrameGraphCallback begin, VkSubpassContents contents)
+{
+    RenderPass renderPass = {};
+    renderPass.name = name;
+    renderPass.begin = begin;
+    renderPass.contents = contents;
+    renderPass.live = false;
+    m_renderPasses.push_back(renderPass);
+    return (uint32_t) (m_renderPasses.size() - 1u);
+}
+
+uint32_t FrameGraph::addPass(const std::string & name, FrameGraphCallback record, uint32_t renderPass)
+{
+    Pass pass = {};
+    pass.name = name;
+    pass.renderPass = renderPass;
+    pass.subpass = 0u;
+    pass.record = record;
+    pass.live = false;
+
+    if (FRAME_GRAPH_NONE != renderPass)
+    {
+        /* Subpasses are recorded between one vkCmdBeginRenderPass and vkCmdEndRenderPass */
+        std::vector<uint32_t> & passes = m_renderPasses[renderPass].passes;
+        if ((!passes.empty()) && ((passes.back() + 1u) != m_passes.size()))
+        {
+            throw std::runtime_error("Passes of render pass " + m_renderPasses[renderPass].name + " must be added one after another!");
+        }
+        pass.subpass = (uint32_t) passes.size();
+        passes.push_back((uint32_t) m_passes.size());
+    }
+
+    m_passes.push_back(pass);
+    return (uint32_t) (m_passes.size() - 1u);
+}
+
+void FrameGraph::addUse(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout, bool write, bool attachment)
+{
+    if (attachment && (FRAME_GRAPH_NONE == m_passes[pass].renderPass))
+    {
+        throw std::runtime_error("Pass " + m_passes[pass].name + " is not part of a render pass and has no attachments!");
+    }
+
+    /* Several uses of one resource in a pass are a single use, e.g. an atomic counter that is read and written */
+    for (auto & use : m_passes[pass].uses)
+    {
+        if (use.resource == resource)
+        {
+            if (use.state.layout != layout)
+            {
+                throw std::runtime_error("Pass " + m_passes[pass].name + " uses " + m_resources[resource].name + " in two layouts!");
+            }
+            use.state.stages |= stages;
+            use.state.access |= access;
+            use.read = use.read || (!write);
+            use.write = use.write || write;
+            use.attachment = use.attachment || attachment;
+            return;
+        }
+    }
+
+    Use use =
+    {
+        .resource   = resource,
+        .state      = {stages, access, layout},
+        .read       = !write,
+        .write      = write,
+        .attachment = attachment,
+    };
+    m_passes[pass].uses.push_back(use);
+}
+
+void FrameGraph::read(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+{
+    addUse(pass, resource, stages, access, layout, false, false);
+}
+
+void FrameGraph::write(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+{
+    addUse(pass, resource, stages, access, layout, true, false);
+}
+
+void FrameGraph::readAttachment(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+{
+    addUse(pass, resource, stages, access, layout, false, true);
+}
+
+void FrameGraph::writeAttachment(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout)
+{
+    addUse(pass, resource, stages, access, layout, true, true);
+}
+
+void FrameGraph::cullPasses(void)
+{
+    /* Walk backwards from the exported resources, a render pass lives or dies with all of its subpasses */
+    std::vector<bool> needed(m_resources.size(), false);
+    for (uint32_t r = 0u; r < m_resources.size(); r++)
+    {
+        needed[r] = m_resources[r].exported;
+    }
+
+    for (uint32_t last = (uint32_t) m_passes.size(); last > 0u;)
+    {
+        uint32_t first = last - 1u;
+        uint32_t renderPass = m_passes[first].renderPass;
+        if (FRAME_GRAPH_NONE != renderPass)
+        {
+            first = m_renderPasses[renderPass].passes.front();
+        }
+
+        bool live = false;
+        for (uint32_t p = first; p < last; p++)
+        {
+            for (const auto & use : m_passes[p].uses)
+            {
+                live = live || (use.write && needed[use.resource]);
+            }
+        }
+
+        if (live)
+        {
+            for (uint32_t p = first; p < last; p++)
+            {
+                m_passes[p].live = true;
+                for (const auto & use : m_passes[p].uses)
+                {
+                    needed[use.resource] = needed[use.resource] || use.read;
+                }
+            }
+            if (FRAME_GRAPH_NONE != renderPass)
+            {
+                m_renderPasses[renderPass].live = true;
+            }
+        }
+        last = first;
+    }
+}
+
+void FrameGraph::computeLifetimes(void)
+{
+    /* Attachments are allocated for the whole render pass, so every resource of a render pass lives as long as the render pass */
+    for (uint32_t p = 0u; p < m_passes.size(); p++)
+    {
+        if (!m_passes[p].live)
+        {
+            continue;
+        }
+
+        uint32_t first = p;
+        uint32_t last = p;
+        if (FRAME_GRAPH_NONE != m_passes[p].renderPass)
+        {
+            first = m_renderPasses[m_passes[p].renderPass].passes.front();
+            last = m_renderPasses[m_passes[p].renderPass].passes.back();
+        }
+
+        for (const auto & use : m_passes[p].uses)
+        {
+            Resource & resource = m_resources[use.resource];
+            resource.firstPass = std::min(resource.firstPass, first);
+            resource.lastPass = (FRAME_GRAPH_NONE == resource.lastPass) ? last : std::max(resource.lastPass, last);
+        }
+    }
+}
+
+void FrameGraph::createTransientImages(void)
+{
+    VkResult result;
+
+    for (auto & resource : m_resources)
+    {
+        if ((!resource.transient) || (FRAME_GRAPH_NONE == resource.firstPass))
+        {
+            continue;
+        }
+
+        resource.images.resize(m_copies);
+        for (uint32_t c = 0u; c < m_copies; c++)
+        {
+            result = vkCreateImage(m_device, &resource.imageInfo, nullptr, &resource.images[c]);
+            if (VK_SUCCESS != result)
+            {
+                throw std::runtime_error("Unable to create frame graph image " + resource.name + "!");
+            }
+        }
+        vkGetImageMemoryRequirements(m_device, resource.images[0u], &resource.requirements);
+    }
+}
+
+void FrameGraph::assignSlots(void)
+{
+    std::vector<uint32_t> transients;
+    for (uint32_t r = 0u; r < m_resources.size(); r++)
+    {
+        if (m_resources[r].transient && (FRAME_GRAPH_NONE != m_resources[r].firstPass))
+        {
+            transients.push_back(r);
+        }
+    }
+
+    /* Largest first, each image goes into the first slot whose images are all dead while it is alive */
+    std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b)
+    {
+        return m_resources[a].requirements.size > m_resources[b].requirements.size;
+    });
+
+    for (uint32_t r : transients)
+    {
+        Resource & resource = m_resources[r];
+        for (uint32_t s = 0u; (s < m_slots.size()) && (FRAME_GRAPH_NONE == resource.slot); s++)
+        {
+            bool fits = (0u != (m_slots[s].typeBits & resource.requirements.memoryTypeBits));
+            for (uint32_t other : m_slots[s].resources)
+            {
+                fits = fits && ((resource.lastPass < m_resources[other].firstPass) || (m_resources[other].lastPass < resource.firstPass));
+            }
+            if (fits)
+            {
+                resource.slot = s;
+            }
+        }
+
+        if (FRAME_GRAPH_NONE == resource.slot)
+        {
+            Slot slot = {};
+            slot.typeBits = resource.requirements.memoryTypeBits;
+            m_slots.push_back(slot);
+            resource.slot = (uint32_t) (m_slots.size() - 1u);
+        }
+
+        m_slots[resource.slot].typeBits &= resource.requirements.memoryTypeBits;
+        m_slots[resource.slot].resources.push_back(r);
+    }
+
+    /* In pass order every image of a slot takes over the memory from the one before it */
+    for (auto & slot : m_slots)
+    {
+        std::sort(slot.resources.begin(), slot.resources.end(), [this](uint32_t a, uint32_t b)
+        {
+            return m_resources[a].firstPass < m_resources[b].firstPass;
+        });
+        for (uint32_t i = 1u; i < slot.resources.size(); i++)
+        {
+            m_resources[slot.resources[i]].aliasOf = slot.resources[i - 1u];
+        }
+    }
+}
+
+void FrameGraph::bindTransientMemory(void)
+{
+    VkResult result;
+
+    /* Sizes follow the current images, which images share a slot was decided once by compile() */
+    for (auto & slot : m_slots)
+    {
+        slot.size = 0u;
+        slot.alignment = 1u;
+        slot.typeBits = UINT32_MAX;
+        for (uint32_t r : slot.resources)
+        {
+            slot.size = std::max(slot.size, m_resources[r].requirements.size);
+            slot.alignment = std::max(slot.alignment, m_resources[r].requirements.alignment);
+            slot.typeBits &= m_resources[r].requirements.memoryTypeBits;
+        }
+        if (0u == slot.typeBits)
+        {
+            throw std::runtime_error("Aliased frame graph images no longer share a memory type!");
+        }
+
+        VkMemoryRequirements requirements =
+        {
+            .size           = slot.size,
+            .alignment      = slot.alignment,
+            .memoryTypeBits = slot.typeBits,
+        };
+        slot.memoryType = m_memoryType(slot.typeBits);
+
+        slot.memory.resize(m_copies);
+        for (uint32_t c = 0u; c < m_copies; c++)
+        {
+            slot.memory[c] = m_allocator->allocate(requirements, slot.memoryType, SUBALLOCATION_OPTIMAL);
+            for (uint32_t r : slot.resources)
+            {
+                vkBindImageMemory(m_device, m_resources[r].images[c], slot.memory[c].memory, slot.memory[c].offset);
+            }
+        }
+    }
+
+    for (auto & resource : m_resources)
+    {
+        if (resource.images.empty())
+        {
+            continue;
+        }
+
+        VkImageViewCreateInfo ivci =
+        {
+            .sType              = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext              = nullptr,
+            .flags              = 0,
+            .image              = VK_NULL_HANDLE,
+            .viewType           = (resource.imageInfo.arrayLayers > 1u) ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D,
+            .format             = resource.imageInfo.format,
+            .components         = {VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY},
+            .subresourceRange   = {resource.aspect, 0u, resource.imageInfo.mipLevels, 0u, resource.imageInfo.arrayLayers},
+        };
+
+        resource.views.resize(m_copies);
+        for (uint32_t c = 0u; c < m_copies; c++)
+        {
+            ivci.image = resource.images[c];
+            result = vkCreateImageView(m_device, &ivci, nullptr, &resource.views[c]);
+            if (VK_SUCCESS != result)
+            {
+                throw std::runtime_error("Unable to create frame graph image view " + resource.name + "!");
+            }
+        }
+    }
+}
+
+void FrameGraph::setImageExtent(uint32_t resource, VkExtent2D extent)
+{
+    m_resources[resource].imageInfo.extent = {extent.width, extent.height, 1u};
+}
+
+void FrameGraph::reallocate(std::vector<VkImage> & images, std::vector<VkImageView> & views, std::vector<MemoryAllocation> & memory)
+{
+    /* Frames in flight may still use the old images, the caller destroys them once their fences signaled */
+    for (auto & resource : m_resources)
+    {
+        images.insert(images.end(), resource.images.begin(), resource.images.end());
+        views.insert(views.end(), resource.views.begin(), resource.views.end());
+        resource.images.clear();
+        resource.views.clear();
+    }
+    for (auto & slot : m_slots)
+    {
+        memory.insert(memory.end(), slot.memory.begin(), slot.memory.end());
+        slot.memory.clear();
+    }
+
+    /* Barriers and subpass dependencies do not depend on the extent, only the images and their memory are replaced */
+    createTransientImages();
+    bindTransientMemory();
+}
+
+void FrameGraph::addDependency(uint32_t renderPass, uint32_t srcSubpass, uint32_t dstSubpass, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages,
+                               VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    /* Pixel local work on both sides lets tilers resolve the dependency per tile */
+    VkDependencyFlags flags = ((VK_SUBPASS_EXTERNAL != srcSubpass) && (VK_SUBPASS_EXTERNAL != dstSubpass) &&
+                               (0 == ((srcStages | dstStages) & ~(VkPipelineStageFlags) FRAMEBUFFER_STAGES))) ? VK_DEPENDENCY_BY_REGION_BIT : 0;
+
+    for (auto & dependency : m_renderPasses[renderPass].dependencies)
+    {
+        if ((dependency.srcSubpass == srcSubpass) && (dependency.dstSubpass == dstSubpass))
+        {
+            dependency.srcStageMask |= srcStages;
+            dependency.dstStageMask |= dstStages;
+            dependency.srcAccessMask |= srcAccess;
+            dependency.dstAccessMask |= dstAccess;
+            dependency.dependencyFlags &= flags;
+            return;
+        }
+    }
+
+    VkSubpassDependency dependency =
+    {
+        .srcSubpass         = srcSubpass,
+        .dstSubpass         = dstSubpass,
+        .srcStageMask       = srcStages,
+        .dstStageMask       = dstStages,
+        .srcAccessMask      = srcAccess,
+        .dstAccessMask      = dstAccess,
+        .dependencyFlags    = flags,
+    };
+    m_renderPasses[renderPass].dependencies.push_back(dependency);
+}
+
+void FrameGraph::addBarrier(std::vector<Barrier> & barriers, const Barrier & barrier)
+{
+    for (auto & existing : barriers)
+    {
+        if ((existing.resource == barrier.resource) && (existing.oldLayout == barrier.oldLayout) && (existing.newLayout == barrier.newLayout))
+        {
+            existing.srcStages |= barrier.srcStages;
+            existing.dstStages |= barrier.dstStages;
+            existing.srcAccess |= barrier.srcAccess;
+            existing.dstAccess |= barrier.dstAccess;
+            return;
+        }
+    }
+    barriers.push_back(barrier);
+}
+
+void FrameGraph::setFinalLayout(uint32_t renderPass, uint32_t resource, VkImageLayout layout)
+{
+    for (auto & finalLayout : m_renderPasses[renderPass].finalLayouts)
+    {
+        if (finalLayout.first == resource)
+        {
+            finalLayout.second = layout;
+            return;
+        }
+    }
+    m_renderPasses[renderPass].finalLayouts.push_back(std::make_pair(resource, layout));
+}
+
+void FrameGraph::addEdge(const Access & source, uint32_t pass, uint32_t resource, const FrameGraphState & state, bool attachment, const Tracking & tracking)
+{
+    /* pass is FRAME_GRAPH_NONE for the transition of an exported resource after the last pass */
+    const Resource & res = m_resources[resource];
+    uint32_t renderPass = (FRAME_GRAPH_NONE != pass) ? m_passes[pass].renderPass : FRAME_GRAPH_NONE;
+    uint32_t srcRenderPass = (FRAME_GRAPH_NONE != source.pass) ? m_passes[source.pass].renderPass : FRAME_GRAPH_NONE;
+    uint32_t srcSubpass = (FRAME_GRAPH_NONE != srcRenderPass) ? m_passes[source.pass].subpass : VK_SUBPASS_EXTERNAL;
+    VkPipelineStageFlags srcStages = (0 != source.stages) ? source.stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    VkPipelineStageFlags dstStages = (0 != state.stages) ? state.stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    VkImageLayout oldLayout = res.image ? tracking.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout newLayout = res.image ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+    /* Both sides in one render pass, attachment layouts follow the attachment references of the subpasses */
+    if ((FRAME_GRAPH_NONE != renderPass) && (srcRenderPass == renderPass))
+    {
+        if ((!attachment) && (oldLayout != newLayout))
+        {
+            throw std::runtime_error("Layout of " + res.name + " would change inside render pass " + m_renderPasses[renderPass].name + "!");
+        }
+        addDependency(renderPass, srcSubpass, m_passes[pass].subpass, srcStages, dstStages, source.access, state.access);
+        return;
+    }
+
+    /* Leaving the render pass it is an attachment of: the final layout does the transition, an external dependency orders what follows */
+    if (tracking.attachment && (FRAME_GRAPH_NONE != srcRenderPass) && (srcRenderPass == tracking.lastRenderPass))
+    {
+        if (res.image)
+        {
+            setFinalLayout(srcRenderPass, resource, newLayout);
+        }
+        /* Nothing to wait for, e.g. the present is ordered by the render done semaphore */
+        if ((VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT != dstStages) || (0 != state.access))
+        {
+            addDependency(srcRenderPass, srcSubpass, VK_SUBPASS_EXTERNAL, srcStages, dstStages, source.access, state.access);
+        }
+        return;
+    }
+
+    /* Entering a render pass as attachment: it is discarded or loaded in the initial layout of its attachment description */
+    if (attachment)
+    {
+        addDependency(renderPass, VK_SUBPASS_EXTERNAL, m_passes[pass].subpass, srcStages, dstStages, source.access, state.access);
+        return;
+    }
+
+    Barrier barrier =
+    {
+        .resource   = resource,
+        .srcStages  = srcStages,
+        .dstStages  = dstStages,
+        .srcAccess  = source.access,
+        .dstAccess  = state.access,
+        .oldLayout  = oldLayout,
+        .newLayout  = newLayout,
+    };
+
+    /* Buffers and sampled images used inside a render pass are made ready before it begins */
+    if (FRAME_GRAPH_NONE == pass)
+    {
+        addBarrier(m_finalBarriers, barrier);
+    }
+    else if (FRAME_GRAPH_NONE != renderPass)
+    {
+        addBarrier(m_renderPasses[renderPass].barriers, barrier);
+    }
+    else
+    {
+        addBarrier(m_passes[pass].barriers, barrier);
+    }
+}
+
+void FrameGraph::computeBarriers(void)
+{
+    std::vector<Tracking> tracking(m_resources.size());
+    for (uint32_t r = 0u; r < m_resources.size(); r++)
+    {
+        tracking[r].write = {FRAME_GRAPH_NONE, m_resources[r].initial.stages, m_resources[r].initial.access};
+        tracking[r].visibleStages = 0;
+        tracking[r].visibleAccess = 0;
+        tracking[r].layout = m_resources[r].initial.layout;
+        tracking[r].attachment = false;
+        tracking[r].lastRenderPass = FRAME_GRAPH_NONE;
+    }
+
+    for (uint32_t p = 0u; p < m_passes.size(); p++)
+    {
+        Pass & pass = m_passes[p];
+        if (!pass.live)
+        {
+            continue;
+        }
+
+        for (const auto & use : pass.uses)
+        {
+            const Resource & resource = m_resources[use.resource];
+            Tracking & state = tracking[use.resource];
+
+            /* An aliased image waits for the last accesses to its memory, its contents are undefined */
+            if ((p == resource.firstPass) && (FRAME_GRAPH_NONE != resource.aliasOf))
+            {
+                state = tracking[resource.aliasOf];
+                state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                state.attachment = false;
+            }
+
+            bool layoutChange = resource.image && (use.state.layout != state.layout);
+
+            if (use.write || layoutChange)
+            {
+                /* Write after read waits for the reads, which already waited for the write; write after write waits for the write */
+                std::vector<Access> sources = state.reads;
+                bool readVisible = (0 == (use.state.stages & ~state.visibleStages)) && (0 == (use.state.access & ~state.visibleAccess));
+                if (sources.empty() || (use.read && (!readVisible)))
+                {
+                    sources.push_back(state.write);
+                }
+                for (const auto & source : sources)
+                {
+                    if ((0 != source.stages) || layoutChange)
+                    {
+                        addEdge(source, p, use.resource, use.state, use.attachment, state);
+                    }
+                }
+
+                /* A layout transition is a write as well, later accesses chain on the stages that waited for it */
+                state.write = {p, use.state.stages, use.write ? use.state.access : (VkAccessFlags) 0};
+                state.reads.clear();
+                state.visibleStages = use.write ? 0 : use.state.stages;
+                state.visibleAccess = use.write ? 0 : use.state.access;
+            }
+            else
+            {
+                bool visible = (0 == (use.state.stages & ~state.visibleStages)) && (0 == (use.state.access & ~state.visibleAccess));
+                if ((!visible) && (0 != state.write.stages))
+                {
+                    addEdge(state.write, p, use.resource, use.state, use.attachment, state);
+                }
+                state.reads.push_back({p, use.state.stages, use.state.access});
+                state.visibleStages |= use.state.stages;
+                state.visibleAccess |= use.state.access;
+            }
+
+            if (resource.image)
+            {
+                state.layout = use.state.layout;
+            }
+            state.attachment = use.attachment;
+            state.lastRenderPass = pass.renderPass;
+        }
+
+        /* Attachments nothing uses afterwards stay in the layout of their last subpass */
+        if ((FRAME_GRAPH_NONE != pass.renderPass) && (m_renderPasses[pass.renderPass].passes.back() == p))
+        {
+            for (uint32_t subpass : m_renderPasses[pass.renderPass].passes)
+            {
+                for (const auto & use : m_passes[subpass].uses)
+                {
+                    if (use.attachment)
+                    {
+                        setFinalLayout(pass.renderPass, use.resource, tracking[use.resource].layout);
+                    }
+                }
+            }
+        }
+    }
+
+    /* Exported resources are handed over in their final state */
+    for (uint32_t r = 0u; r < m_resources.size(); r++)
+    {
+        Resource & resource = m_resources[r];
+        Tracking & state = tracking[r];
+        if ((!resource.exported) || (FRAME_GRAPH_NONE == resource.firstPass))
+        {
+            continue;
+        }
+
+        bool layoutChange = resource.image && (resource.final.layout != state.layout);
+        std::vector<Access> sources = state.reads;
+        sources.push_back(state.write);
+        for (const auto & source : sources)
+        {
+            if (((0 != source.stages) && (0 != resource.final.stages)) || layoutChange)
+            {
+                addEdge(source, FRAME_GRAPH_NONE, r, resource.final, false, state);
+            }
+        }
+    }
+}
+
+void FrameGraph::compile(VkDevice device, DeviceMemoryAllocator & allocator, const std::function<uint32_t(uint32_t typeBits)> & memoryType, uint32_t copies)
+{
+    m_device = device;
+    m_allocator = &allocator;
+    m_memoryType = memoryType;
+    m_copies = copies;
+
+    cullPasses();
+    computeLifetimes();
+    createTransientImages();
+    assignSlots();
+    bindTransientMemory();
+    computeBarriers();
+}
+
+const std::vector<VkSubpassDependency> & FrameGraph::getSubpassDependencies(uint32_t renderPass)
+{
+    return m_renderPasses[renderPass].dependencies;
+}
+
+VkImageLayout FrameGraph::getFinalLayout(uint32_t renderPass, uint32_t resource)
+{
+    for (const auto & finalLayout : m_renderPasses[renderPass].finalLayouts)
+    {
+        if (finalLayout.first == resource)
+        {
+            return finalLayout.second;
+        }
+    }
+    throw std::runtime_error(m_resources[resource].name + " is not an attachment of render pass " + m_renderPasses[renderPass].name + "!");
+}
+
+uint32_t FrameGraph::getMemoryType(uint32_t resource)
+{
+    return m_slots[m_resources[resource].slot].memoryType;
+}
+
+VkImage FrameGraph::getImage(uint32_t resource, uint32_t copy)
+{
+    return m_resources[resource].transient ? m_resources[resource].images[copy] : m_resources[resource].bound;
+}
+
+VkImageView FrameGraph::getImageView(uint32_t resource, uint32_t copy)
+{
+    if (!m_resources[resource].transient)
+    {
+        throw std::runtime_error("Views of imported image " + m_resources[resource].name + " are owned by the application!");
+    }
+    return m_resources[resource].views[copy];
+}
+
+void FrameGraph::bindImage(uint32_t resource, VkImage image)
+{
+    m_resources[resource].bound = image;
+}
+
+void FrameGraph::recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> & barriers, const FrameGraphContext & context)
+{
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    /* Buffers share one global memory barrier, images need their own for the layout */
+    VkPipelineStageFlags srcStages = 0;
+    VkPipelineStageFlags dstStages = 0;
+    VkMemoryBarrier memoryBarrier =
+    {
+        .sType          = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext          = nullptr,
+        .srcAccessMask  = 0,
+        .dstAccessMask  = 0,
+    };
+    uint32_t memoryBarrierCount = 0u;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+
+    for (const auto & barrier : barriers)
+    {
+        const Resource & resource = m_resources[barrier.resource];
+        srcStages |= barrier.srcStages;
+        dstStages |= barrier.dstStages;
+
+        if (!resource.image)
+        {
+            memoryBarrier.srcAccessMask |= barrier.srcAccess;
+            memoryBarrier.dstAccessMask |= barrier.dstAccess;
+            memoryBarrierCount = 1u;
+            continue;
+        }
+
+        VkImageMemoryBarrier imb =
+        {
+            .sType                  = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .pNext                  = nullptr,
+            .srcAccessMask          = barrier.srcAccess,
+            .dstAccessMask          = barrier.dstAccess,
+            .oldLayout              = barrier.oldLayout,
+            .newLayout              = barrier.newLayout,
+            .srcQueueFamilyIndex    = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex    = VK_QUEUE_FAMILY_IGNORED,
+            .image                  = getImage(barrier.resource, context.frame),
+            .subresourceRange       = {resource.aspect, 0u, VK_REMAINING_MIP_LEVELS, 0u, VK_REMAINING_ARRAY_LAYERS},
+        };
+        imageBarriers.push_back(imb);
+    }
+
+    vkCmdPipelineBarrier(commandBuffer, srcStages, dstStages, 0, memoryBarrierCount, &memoryBarrier, 0u, nullptr,
+                         (uint32_t) imageBarriers.size(), imageBarriers.data());
+}
+
+void FrameGraph::execute(VkCommandBuffer commandBuffer, const FrameGraphContext & context)
+{
+    for (const auto & pass : m_passes)
+    {
+        if (!pass.live)
+        {
+            continue;
+        }
+
+        if (FRAME_GRAPH_NONE == pass.renderPass)
+        {
+            recordBarriers(commandBuffer, pass.barriers, context);
+            pass.record(commandBuffer, context);
+            continue;
+        }
+
+        RenderPass & renderPass = m_renderPasses[pass.renderPass];
+        if (0u == pass.subpass)
+        {
+            recordBarriers(commandBuffer, renderPass.barriers, context);
+            renderPass.begin(commandBuffer, context);
+        }
+        else
+        {
+            vkCmdNextSubpass(commandBuffer, renderPass.contents);
+        }
+
+        pass.record(commandBuffer, context);
+
+        if ((pass.subpass + 1u) == renderPass.passes.size())
+        {
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    }
+
+    recordBarriers(commandBuffer, m_finalBarriers, context);
+}
+
+void FrameGraph::printSummary(void)
+{
+    std::cout << "Frame graph:" << std::endl;
+    for (const auto & pass : m_passes)
+    {
+        uint32_t barrierCount = (uint32_t) pass.barriers.size();
+        std::cout << "  " << pass.name;
+        if (FRAME_GRAPH_NONE != pass.renderPass)
+        {
+            std::cout << " (" << m_renderPasses[pass.renderPass].name << ", subpass " << pass.subpass << ")";
+            barrierCount = (0u == pass.subpass) ? (uint32_t) m_renderPasses[pass.renderPass].barriers.size() : 0u;
+        }
+        if (pass.live)
+        {
+            std::cout << ": " << barrierCount << " barriers before" << std::endl;
+        }
+        else
+        {
+            std::cout << ": culled" << std::endl;
+        }
+    }
+
+    for (const auto & renderPass : m_renderPasses)
+    {
+        if (renderPass.live)
+        {
+            std::cout << "  render pass " << renderPass.name << ": " << renderPass.dependencies.size() << " subpass dependencies" << std::endl;
+        }
+    }
+
+    for (uint32_t s = 0u; s < m_slots.size(); s++)
+    {
+        std::cout << "  transient memory " << s << ", " << m_slots[s].size << " B x " << m_copies << ":";
+        for (uint32_t r : m_slots[s].resources)
+        {
+            std::cout << " " << m_resources[r].name;
+        }
+        std::cout << std::endl;
+    }
+}
+
+void FrameGraph::destroy(void)
+{
+    for (auto & resource : m_resources)
+    {
+        for (auto view : resource.views)
+        {
+            vkDestroyImageView(m_device, view, nullptr);
+        }
+        for (auto image : resource.images)
+        {
+            vkDestroyImage(m_device, image, nullptr);
+        }
+    }
+    for (auto & slot : m_slots)
+    {
+        for (auto & memory : slot.memory)
+        {
+            m_allocator->free(memory);
+        }
+    }
+
+    m_resources.clear();
+    m_passes.clear();
+    m_renderPasses.clear();
+    m_slots.clear();
+    m_finalBarriers.clear();
+}
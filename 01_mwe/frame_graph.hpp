@@ -0,0 +1,194 @@
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+#include "memory_allocator.hpp"
+
+#ifndef FRAME_GRAPH_GUARD
+#define FRAME_GRAPH_GUARD
+
+/* No pass, no render pass or no resource */
+#define FRAME_GRAPH_NONE    UINT32_MAX
+
+/* How a resource is used by a pass, or how the work before the frame left it */
+struct FrameGraphState
+{
+    VkPipelineStageFlags    stages;
+    VkAccessFlags           access;
+    VkImageLayout           layout;     /* images only */
+};
+
+/* Handed to every callback while the graph is executed */
+struct FrameGraphContext
+{
+    uint32_t    frame;      /* frame in flight, selects the copy of transient images */
+    uint32_t    target;     /* swapchain or offscreen image the frame renders into */
+};
+
+typedef std::function<void(VkCommandBuffer commandBuffer, const FrameGraphContext & context)> FrameGraphCallback;
+
+/*
+ * Passes declare the resources they read and write, compile() derives everything else:
+ * - passes that contribute nothing to an exported resource are culled,
+ * - pipeline barriers between passes, merged into one vkCmdPipelineBarrier per pass,
+ * - subpass dependencies and final attachment layouts of the render passes,
+ * - memory of transient images whose lifetimes do not overlap is aliased.
+ * Passes are executed in declaration order, the passes of one render pass are its subpasses.
+ */
+class FrameGraph
+{
+    private:
+        struct Access
+        {
+            uint32_t                pass;
+            VkPipelineStageFlags    stages;
+            VkAccessFlags           access;
+        };
+
+        struct Resource
+        {
+            std::string                     name;
+            bool                            image;
+            bool                            transient;
+            bool                            exported;
+            FrameGraphState                 initial;
+            FrameGraphState                 final;
+            VkImageCreateInfo               imageInfo;
+            VkImageAspectFlags              aspect;
+            VkImage                         bound;          /* imported images, set per frame */
+            std::vector<VkImage>            images;         /* transient images, one per copy */
+            std::vector<VkImageView>        views;
+            VkMemoryRequirements            requirements;
+            uint32_t                        firstPass;
+            uint32_t                        lastPass;
+            uint32_t                        slot;
+            uint32_t                        aliasOf;        /* transient that used the memory before */
+        };
+
+        struct Use
+        {
+            uint32_t            resource;
+            FrameGraphState     state;
+            bool                read;
+            bool                write;
+            bool                attachment;
+        };
+
+        struct Barrier
+        {
+            uint32_t                resource;
+            VkPipelineStageFlags    srcStages;
+            VkPipelineStageFlags    dstStages;
+            VkAccessFlags           srcAccess;
+            VkAccessFlags           dstAccess;
+            VkImageLayout           oldLayout;
+            VkImageLayout           newLayout;
+        };
+
+        struct Pass
+        {
+            std::string             name;
+            uint32_t                renderPass;
+            uint32_t                subpass;
+            FrameGraphCallback      record;
+            std::vector<Use>        uses;
+            bool                    live;
+            std::vector<Barrier>    barriers;       /* recorded before the pass */
+        };
+
+        struct RenderPass
+        {
+            std::string                         name;
+            FrameGraphCallback                  begin;      /* vkCmdBeginRenderPass, the graph steps through the subpasses and ends it */
+            VkSubpassContents                   contents;
+            std::vector<uint32_t>               passes;
+            bool                                live;
+            std::vector<Barrier>                barriers;   /* recorded before the render pass begins */
+            std::vector<VkSubpassDependency>    dependencies;
+            std::vector<std::pair<uint32_t, VkImageLayout>> finalLayouts;
+        };
+
+        /* Block of memory shared by transient images that are never alive at the same time */
+        struct Slot
+        {
+            VkDeviceSize                    size;
+            VkDeviceSize                    alignment;
+            uint32_t                        typeBits;
+            uint32_t                        memoryType;
+            std::vector<uint32_t>           resources;
+            std::vector<MemoryAllocation>   memory;         /* one per copy */
+        };
+
+        /* Hazard tracking of one resource while the barriers are derived */
+        struct Tracking
+        {
+            Access                  write;
+            std::vector<Access>     reads;          /* since the last write */
+            VkPipelineStageFlags    visibleStages;  /* the last write is visible to these stages and accesses */
+            VkAccessFlags           visibleAccess;
+            VkImageLayout           layout;
+            bool                    attachment;     /* last use was as an attachment of lastRenderPass */
+            uint32_t                lastRenderPass;
+        };
+
+        VkDevice                    m_device = VK_NULL_HANDLE;
+        DeviceMemoryAllocator *     m_allocator = nullptr;
+        std::vector<Resource>       m_resources;
+        std::vector<Pass>           m_passes;
+        std::vector<RenderPass>     m_renderPasses;
+        std::vector<Slot>           m_slots;
+        std::vector<Barrier>        m_finalBarriers;    /* recorded after the last pass, e.g. transitions of exported images */
+        std::function<uint32_t(uint32_t typeBits)> m_memoryType;
+        uint32_t                    m_copies = 1u;
+
+        uint32_t addResource(const std::string & name, bool image, VkImageAspectFlags aspect, const FrameGraphState & initial);
+        void addUse(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout, bool write, bool attachment);
+        void cullPasses(void);
+        void computeLifetimes(void);
+        void createTransientImages(void);
+        void assignSlots(void);
+        void bindTransientMemory(void);
+        void addDependency(uint32_t renderPass, uint32_t srcSubpass, uint32_t dstSubpass, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages,
+                           VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+        void addBarrier(std::vector<Barrier> & barriers, const Barrier & barrier);
+        void setFinalLayout(uint32_t renderPass, uint32_t resource, VkImageLayout layout);
+        void addEdge(const Access & source, uint32_t pass, uint32_t resource, const FrameGraphState & state, bool attachment, const Tracking & tracking);
+        void computeBarriers(void);
+        void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier> & barriers, const FrameGraphContext & context);
+
+    public:
+        /* Resources that live outside of the graph, initial is the state the work before the frame leaves them in */
+        uint32_t importBuffer(const std::string & name, const FrameGraphState & initial);
+        uint32_t importImage(const std::string & name, VkImageAspectFlags aspect, const FrameGraphState & initial);
+        /* Image created, and aliased, by the graph; extent, format, samples and usage come from imageInfo */
+        uint32_t createImage(const std::string & name, const VkImageCreateInfo & imageInfo, VkImageAspectFlags aspect);
+        /* Used after the frame, e.g. presented; passes writing it are never culled */
+        void exportResource(uint32_t resource, const FrameGraphState & final);
+
+        uint32_t addRenderPass(const std::string & name, FrameGraphCallback begin, VkSubpassContents contents);
+        uint32_t addPass(const std::string & name, FrameGraphCallback record, uint32_t renderPass = FRAME_GRAPH_NONE);
+        void read(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        void write(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED);
+        void readAttachment(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout);
+        void writeAttachment(uint32_t pass, uint32_t resource, VkPipelineStageFlags stages, VkAccessFlags access, VkImageLayout layout);
+
+        /* copies: independent sets of transient images, one per frame in flight */
+        void compile(VkDevice device, DeviceMemoryAllocator & allocator, const std::function<uint32_t(uint32_t typeBits)> & memoryType, uint32_t copies);
+
+        const std::vector<VkSubpassDependency> & getSubpassDependencies(uint32_t renderPass);
+        VkImageLayout getFinalLayout(uint32_t renderPass, uint32_t resource);
+        uint32_t getMemoryType(uint32_t resource);
+        VkImage getImage(uint32_t resource, uint32_t copy);
+        VkImageView getImageView(uint32_t resource, uint32_t copy);
+        void bindImage(uint32_t resource, VkImage image);
+
+        /* E.g. after a resize: the graph's images are recreated, the old ones are handed over for deferred destruction */
+        void setImageExtent(uint32_t resource, VkExtent2D extent);
+        void reallocate(std::vector<VkImage> & images, std::vector<VkImageView> & views, std::vector<MemoryAllocation> & memory);
+
+        void execute(VkCommandBuffer commandBuffer, const FrameGraphContext & context);
+        void printSummary(void);
+        void destroy(void);
+};
+#endif
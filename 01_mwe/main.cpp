@@ -1,82 +1,194 @@
-#include "example.hpp"
-#include <cmath>
-
-#include "glm/glm/vec3.hpp"
-#include "glm/glm/vec4.hpp"
-#include "glm/glm/mat4x4.hpp"
-#include "glm/glm/gtc/matrix_transform.hpp"
-
-
-extern Vertex my_cube[36];
-
-glm::mat4 camera(float Translate, glm::vec2 const &Rotate)
-{
-    #if 0
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(320.0f, 240.0f, -50.0f));
-    model = glm::scale(model, glm::vec3(10.0f, 10.0f, 10.0f));
-    model = glm::rotate(model, (float)(m_pi/4.), glm::vec3(0.0f, 1.0f, 0.0f));
-    //model = glm::rotate(model, (float)(m_pi/2.), glm::vec3(1.0f, 0.0f, 0.0f));
-
-    glm::mat4 view = glm::mat4(1.0f);
-    view = glm::translate(view, glm::vec3(-320.0f, -240.0f, -50.f));
-
-    glm::mat4 projection = glm::perspective(45.0f, 4.0f/3.0f, 0.1f, 1000.0f);
-
-    //glm::mat4 projection = glm::ortho(0.0f, 640.0f, 0.0f, 480.0f, 0.1f, 100.0f);
-    return projection * view * model; 
-    #else
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(1.0f, 1.0f, -50.0f));
-    model = glm::scale(model, glm::vec3(10.0f, 10.0f, 10.0f));
-    model = glm::rotate(model, (float)(glm::radians(45.0f)), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, (float)(glm::radians(15.0f)), glm::vec3(1.0f, 0.0f, 0.0f));
-
-    glm::mat4 view = glm::mat4(1.0f);
-    view = glm::translate(view, glm::vec3(-0.5f, -0.5f, 100.f));
-
-    glm::mat4 projection = glm::scale(glm::perspective(45.0f, 4.0f/3.0f, 0.1f, 1000.0f), glm::vec3(1.0f, 1.0f, -1.0f));
-
-    //glm::mat4 projection = glm::ortho(0.0f, 640.0f, 0.0f, 480.0f, 0.1f, 100.0f);
-    return projection * view * model; 
-    #endif
-}
-
-int main(void)
-{
-    Example vulkan_example;
-    /* compute new coordinates */
-    uint32_t numberOfVertices = Example::getCubeVerticesCount();
-
-    glm::mat4 my_camera = camera(0.f, glm::vec2(0.f, 0.f));
-
-    Vertex tmp_cube[numberOfVertices];
-    memcpy(tmp_cube, my_cube, Example::getCubeSizeBytes());
-
-    for (uint32_t i = 0; i < numberOfVertices; i++)
-    {
-        #if 1
-        my_cube[i].coord = my_camera * tmp_cube[i].coord;
-        #endif
-    }
-
-    vulkan_example.createInstance();
-    vulkan_example.createWindow();
-    vulkan_example.createDevice();
-    vulkan_example.createRenderPass();
-    vulkan_example.createSwapchain();
-    vulkan_example.createDepthResources();
-    vulkan_example.createImageViews();
-    vulkan_example.createRenderPass();
-    vulkan_example.createPipeline();
-    vulkan_example.createFramebuffers();
-    vulkan_example.createCommandBuffers();
-    vulkan_example.createSemaphores();
-    vulkan_example.createFences();
-
-    vulkan_example.run();
-
-    vulkan_example.cleanup();
-
-    return 0;
+#include "example.hpp"
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+int main(int argc, char ** argv)
+{
+    Example vulkan_example;
+    VkBool32 headless = VK_FALSE;
+    uint32_t frameCount = 1000u;
+    uint32_t gridCount = 0u;
+    uint32_t instancesPerDraw = 0u;
+    uint32_t threadCount = 0u;
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    uint32_t imageCount = 2u;
+    uint32_t framesInFlight = 2u;
+    const char * profilePath = nullptr;
+    VkBool32 pipelineStatistics = VK_FALSE;
+    uint32_t initThreadCount = 0u;
+    const char * shaderDirectory = nullptr;
+    const char * devicePreference = nullptr;
+    const char * meshPath = nullptr;
+    VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
+    uint32_t sampleCount = 1u;
+    VkBool32 gpuCulling = VK_FALSE;
+    VkBool32 depthPrepass = VK_FALSE;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (0 == strcmp(argv[i], "--headless"))
+        {
+            headless = VK_TRUE;
+        }
+        else if ((0 == strcmp(argv[i], "--frames")) && ((i + 1) < argc))
+        {
+            frameCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--grid")) && ((i + 1) < argc))
+        {
+            gridCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--batch")) && ((i + 1) < argc))
+        {
+            instancesPerDraw = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--threads")) && ((i + 1) < argc))
+        {
+            threadCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--present-mode")) && ((i + 1) < argc))
+        {
+            if (!Example::parsePresentMode(argv[++i], presentMode))
+            {
+                std::cerr << "Unknown present mode " << argv[i] << ", expected fifo, fifo_relaxed, mailbox or immediate" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if ((0 == strcmp(argv[i], "--images")) && ((i + 1) < argc))
+        {
+            imageCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--frames-in-flight")) && ((i + 1) < argc))
+        {
+            framesInFlight = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--profile")) && ((i + 1) < argc))
+        {
+            profilePath = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--pipeline-stats"))
+        {
+            pipelineStatistics = VK_TRUE;
+        }
+        else if ((0 == strcmp(argv[i], "--init-threads")) && ((i + 1) < argc))
+        {
+            initThreadCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--shader-dir")) && ((i + 1) < argc))
+        {
+            shaderDirectory = argv[++i];
+        }
+        else if (0 == strcmp(argv[i], "--gpu-cull"))
+        {
+            gpuCulling = VK_TRUE;
+        }
+        else if (0 == strcmp(argv[i], "--depth-prepass"))
+        {
+            depthPrepass = VK_TRUE;
+        }
+        else if ((0 == strcmp(argv[i], "--device")) && ((i + 1) < argc))
+        {
+            devicePreference = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--mesh")) && ((i + 1) < argc))
+        {
+            meshPath = argv[++i];
+        }
+        else if ((0 == strcmp(argv[i], "--depth-format")) && ((i + 1) < argc))
+        {
+            if (!Example::parseDepthFormat(argv[++i], depthFormat))
+            {
+                std::cerr << "Unknown depth format " << argv[i] << ", expected d16, d24s8 or d32" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if ((0 == strcmp(argv[i], "--samples")) && ((i + 1) < argc))
+        {
+            sampleCount = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+    }
+
+    if (0u != gridCount)
+    {
+        /* Stress scene, all cubes are drawn with a single instanced draw call */
+        vulkan_example.createGridScene(gridCount);
+    }
+
+    /* 0 keeps the defaults, one instanced draw and one recording thread per core */
+    vulkan_example.setInstancesPerDraw(instancesPerDraw);
+    vulkan_example.setRecordingThreads(threadCount);
+
+    /* Frustum culling in a compute shader, the scene is drawn with one indirect draw */
+    vulkan_example.setGpuCulling(gpuCulling);
+
+    /* Depth-only pass first, then the color pass shades only the visible fragment of every pixel */
+    vulkan_example.setDepthPrepass(depthPrepass);
+
+    /* Preferred depth format, falls back to the most precise supported one */
+    vulkan_example.setDepthFormat(depthFormat);
+
+    /* MSAA, clamped to what the device supports for color and depth attachments */
+    vulkan_example.setSampleCount(sampleCount);
+
+    /* Frame pacing, validated against the surface when the swapchain is created */
+    vulkan_example.setPresentMode(presentMode);
+    vulkan_example.setSwapchainImageCount(imageCount);
+    vulkan_example.setFramesInFlight(framesInFlight);
+
+    if ((nullptr != profilePath) || (VK_TRUE == pipelineStatistics))
+    {
+        vulkan_example.setProfiling((nullptr != profilePath) ? profilePath : "", pipelineStatistics);
+    }
+
+    if (nullptr != shaderDirectory)
+    {
+        /* vert.spv and frag.spv from this directory replace the built-in shaders */
+        vulkan_example.setShaderDirectory(shaderDirectory);
+    }
+
+    if (nullptr != meshPath)
+    {
+        /* Converted by example_mesh_convert, replaces the built-in cube */
+        vulkan_example.setMeshFile(meshPath);
+    }
+
+    if (nullptr != devicePreference)
+    {
+        /* Index or part of the name, overrides MWE_DEVICE */
+        vulkan_example.setDevicePreference(devicePreference);
+    }
+
+    if (VK_TRUE == headless)
+    {
+        /* Render into offscreen images, GLFW is never touched */
+        vulkan_example.setHeadless(VK_TRUE);
+    }
+
+    /* Initialization runs as a dependency graph, independent create* steps overlap */
+    ThreadPool initPool;
+    if (1u != initThreadCount)
+    {
+        initPool.init((0u == initThreadCount) ? 0u : (initThreadCount - 1u));
+    }
+
+    TaskGraph initGraph;
+    vulkan_example.buildInitGraph(initGraph);
+    initGraph.run(initPool);
+    initPool.destroy();
+    initGraph.printTimings();
+
+    if (VK_TRUE == headless)
+    {
+        vulkan_example.runHeadless(frameCount);
+    }
+    else
+    {
+        vulkan_example.run();
+    }
+
+    vulkan_example.cleanup();
+
+    return 0;
 }
\ No newline at end of file
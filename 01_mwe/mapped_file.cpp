@@ -0,0 +1,109 @@
+#include <stdexcept>
+#include <algorithm>
+#include "mapped_file.hpp"
+
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+void MappedFile::map(const std::string & path)
+{
+    release();
+
+#if defined _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+    {
+        throw std::runtime_error("Unable to open file!");
+    }
+
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    m_fileMapping = (0 != fileSize.QuadPart) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (nullptr == m_fileMapping)
+    {
+        throw std::runtime_error("Unable to map file!");
+    }
+
+    m_mapping = MapViewOfFile(m_fileMapping, FILE_MAP_READ, 0, 0, 0);
+    m_size = (size_t) fileSize.QuadPart;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        throw std::runtime_error("Unable to open file!");
+    }
+
+    struct stat status;
+    fstat(file, &status);
+    m_size = (size_t) status.st_size;
+    m_mapping = (0u != m_size) ? mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    close(file);
+    if (MAP_FAILED == m_mapping)
+    {
+        m_mapping = nullptr;
+    }
+#endif
+
+    if (nullptr == m_mapping)
+    {
+        release();
+        throw std::runtime_error("Unable to map file!");
+    }
+}
+
+void MappedFile::adviseSequential(void)
+{
+#if !defined _WIN32
+    if (nullptr != m_mapping)
+    {
+        madvise(m_mapping, m_size, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+void MappedFile::discard(size_t offset, size_t size)
+{
+#if defined _WIN32
+    /* Clean file pages are trimmed from the working set by the system, unmapping them early is not possible per range */
+    (void) offset;
+    (void) size;
+#else
+    /* Only whole pages inside the range, the first and last page may still be needed by the neighbouring ranges */
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t begin = (offset + pageSize - 1u) / pageSize * pageSize;
+    size_t end = std::min(offset + size, m_size) / pageSize * pageSize;
+    if ((nullptr != m_mapping) && (begin < end))
+    {
+        madvise(static_cast<uint8_t *>(m_mapping) + begin, end - begin, MADV_DONTNEED);
+    }
+#endif
+}
+
+void MappedFile::release(void)
+{
+    if (nullptr != m_mapping)
+    {
+#if defined _WIN32
+        UnmapViewOfFile(m_mapping);
+#else
+        munmap(m_mapping, m_size);
+#endif
+    }
+#if defined _WIN32
+    if (nullptr != m_fileMapping)
+    {
+        CloseHandle(m_fileMapping);
+    }
+    m_fileMapping = nullptr;
+#endif
+
+    m_mapping = nullptr;
+    m_size = 0u;
+}
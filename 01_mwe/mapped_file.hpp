@@ -0,0 +1,30 @@
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef MAPPED_FILE_GUARD
+#define MAPPED_FILE_GUARD
+
+/* Read-only memory mapping of a whole file, pages are read on first access instead of being copied up front */
+class MappedFile
+{
+    private:
+        void *              m_mapping = nullptr;
+        size_t              m_size = 0u;        /* bytes */
+#if defined _WIN32
+        void *              m_fileMapping = nullptr;
+#endif
+
+    public:
+        void map(const std::string & path);
+
+        const uint8_t * data(void) { return static_cast<const uint8_t *>(m_mapping); }
+        size_t size(void) { return m_size; }
+
+        /* Hints for streaming through the file once: read ahead, and drop pages that were consumed */
+        void adviseSequential(void);
+        void discard(size_t offset, size_t size);
+
+        void release(void);
+};
+#endif
@@ -0,0 +1,273 @@
+#include <iostream>
+#include <stdexcept>
+#include "memory_allocator.hpp"
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1u) & ~(alignment - 1u);
+}
+
+/* Linear and optimal resources must not share a bufferImageGranularity page */
+static bool isGranularityConflict(eSuballocationType first, eSuballocationType second)
+{
+    return (SUBALLOCATION_FREE != first) && (SUBALLOCATION_FREE != second) && (first != second);
+}
+
+static bool isOnSamePage(VkDeviceSize lastByteOfFirst, VkDeviceSize firstByteOfSecond, VkDeviceSize pageSize)
+{
+    return (lastByteOfFirst & ~(pageSize - 1u)) == (firstByteOfSecond & ~(pageSize - 1u));
+}
+
+void DeviceMemoryAllocator::init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    m_device = device;
+    m_bufferImageGranularity = properties.limits.bufferImageGranularity;
+    m_preferredBlockSize = preferredBlockSize;
+    m_pools.resize(m_memoryProperties.memoryTypeCount);
+}
+
+uint32_t DeviceMemoryAllocator::createBlock(uint32_t memoryType, VkDeviceSize size)
+{
+    VkResult result;
+    Block block;
+
+    VkMemoryAllocateInfo mai =
+    {
+        .sType              = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext              = nullptr,
+        .allocationSize     = size,
+        .memoryTypeIndex    = memoryType,
+    };
+
+    result = vkAllocateMemory(m_device, &mai, nullptr, &block.memory);
+    if (VK_SUCCESS != result)
+    {
+        std::cout << "vkAllocateMemory error " << std::dec << result << ", memory type " << memoryType << ", size " << size << std::endl;
+        throw std::runtime_error("Unable to allocate device memory block!");
+    }
+    m_deviceAllocationCount++;
+
+    /* Host visible blocks stay mapped, a VkDeviceMemory may only be mapped once */
+    block.mapped = nullptr;
+    if (0u != (m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+    {
+        vkMapMemory(m_device, block.memory, 0u, VK_WHOLE_SIZE, 0, &block.mapped);
+    }
+
+    block.size = size;
+    block.suballocations.push_back({0u, size, SUBALLOCATION_FREE});
+
+    m_pools[memoryType].push_back(block);
+    return (uint32_t) (m_pools[memoryType].size() - 1u);
+}
+
+bool DeviceMemoryAllocator::tryAllocate(Block & block, VkDeviceSize size, VkDeviceSize alignment, eSuballocationType type, VkDeviceSize & offset)
+{
+    std::vector<Suballocation> & suballocations = block.suballocations;
+
+    /* First fit */
+    for (size_t i = 0u; i < suballocations.size(); i++)
+    {
+        const Suballocation range = suballocations[i];
+        if ((SUBALLOCATION_FREE != range.type) || (range.size < size))
+        {
+            continue;
+        }
+
+        VkDeviceSize start = alignUp(range.offset, alignment);
+
+        if ((i > 0u) && isGranularityConflict(suballocations[i - 1u].type, type) &&
+            isOnSamePage(range.offset - 1u, start, m_bufferImageGranularity))
+        {
+            start = alignUp(start, m_bufferImageGranularity);
+        }
+
+        if ((start + size) > (range.offset + range.size))
+        {
+            continue;
+        }
+
+        if (((i + 1u) < suballocations.size()) && isGranularityConflict(type, suballocations[i + 1u].type) &&
+            isOnSamePage(start + size - 1u, suballocations[i + 1u].offset, m_bufferImageGranularity))
+        {
+            continue;
+        }
+
+        /* Split into [padding][allocation][remainder], empty parts are dropped */
+        std::vector<Suballocation> split;
+        if (start > range.offset)
+        {
+            split.push_back({range.offset, start - range.offset, SUBALLOCATION_FREE});
+        }
+        split.push_back({start, size, type});
+        if ((range.offset + range.size) > (start + size))
+        {
+            split.push_back({start + size, (range.offset + range.size) - (start + size), SUBALLOCATION_FREE});
+        }
+
+        suballocations.erase(suballocations.begin() + i);
+        suballocations.insert(suballocations.begin() + i, split.begin(), split.end());
+
+        offset = start;
+        return true;
+    }
+
+    return false;
+}
+
+MemoryAllocation DeviceMemoryAllocator::allocate(const VkMemoryRequirements & requirements, uint32_t memoryType, eSuballocationType type)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MemoryAllocation allocation;
+    std::vector<Block> & pool = m_pools[memoryType];
+    VkDeviceSize offset = 0u;
+    uint32_t blockIndex = UINT32_MAX;
+
+    for (uint32_t i = 0u; i < pool.size(); i++)
+    {
+        if (tryAllocate(pool[i], requirements.size, requirements.alignment, type, offset))
+        {
+            blockIndex = i;
+            break;
+        }
+    }
+
+    if (UINT32_MAX == blockIndex)
+    {
+        /* Small heaps (integrated GPUs, BAR memory) get smaller blocks, oversized requests their own block */
+        VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        VkDeviceSize blockSize = m_preferredBlockSize;
+        if ((heapSize / 8u) < blockSize)
+        {
+            blockSize = alignUp(heapSize / 8u, 1024u * 1024u);
+        }
+        if (requirements.size > blockSize)
+        {
+            blockSize = alignUp(requirements.size, m_bufferImageGranularity);
+        }
+
+        blockIndex = createBlock(memoryType, blockSize);
+        tryAllocate(pool[blockIndex], requirements.size, requirements.alignment, type, offset);
+    }
+
+    allocation.memory       = pool[blockIndex].memory;
+    allocation.offset       = offset;
+    allocation.size         = requirements.size;
+    allocation.memoryType   = memoryType;
+    allocation.block        = blockIndex;
+    allocation.mapped       = (nullptr != pool[blockIndex].mapped) ? (static_cast<char *>(pool[blockIndex].mapped) + offset) : nullptr;
+
+    return allocation;
+}
+
+void DeviceMemoryAllocator::free(MemoryAllocation & allocation)
+{
+    if (VK_NULL_HANDLE == allocation.memory)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Suballocation> & suballocations = m_pools[allocation.memoryType][allocation.block].suballocations;
+
+    for (size_t i = 0u; i < suballocations.size(); i++)
+    {
+        if (suballocations[i].offset != allocation.offset)
+        {
+            continue;
+        }
+
+        suballocations[i].type = SUBALLOCATION_FREE;
+
+        /* Merge with free neighbours, the block keeps its memory for reuse */
+        if (((i + 1u) < suballocations.size()) && (SUBALLOCATION_FREE == suballocations[i + 1u].type))
+        {
+            suballocations[i].size += suballocations[i + 1u].size;
+            suballocations.erase(suballocations.begin() + i + 1u);
+        }
+        if ((i > 0u) && (SUBALLOCATION_FREE == suballocations[i - 1u].type))
+        {
+            suballocations[i - 1u].size += suballocations[i].size;
+            suballocations.erase(suballocations.begin() + i);
+        }
+        break;
+    }
+
+    allocation = MemoryAllocation();
+}
+
+MemoryStatistics DeviceMemoryAllocator::getStatistics(uint32_t memoryType)
+{
+    MemoryStatistics statistics = {0u};
+    VkDeviceSize freeBytes = 0u;
+
+    for (const auto & block : m_pools[memoryType])
+    {
+        statistics.blockCount++;
+        statistics.reservedBytes += block.size;
+
+        for (const auto & range : block.suballocations)
+        {
+            if (SUBALLOCATION_FREE == range.type)
+            {
+                statistics.freeRangeCount++;
+                freeBytes += range.size;
+                if (range.size > statistics.largestFreeRange)
+                {
+                    statistics.largestFreeRange = range.size;
+                }
+            }
+            else
+            {
+                statistics.allocationCount++;
+                statistics.usedBytes += range.size;
+            }
+        }
+    }
+
+    if (0u != freeBytes)
+    {
+        statistics.fragmentation = 1.f - ((float) statistics.largestFreeRange / (float) freeBytes);
+    }
+
+    return statistics;
+}
+
+void DeviceMemoryAllocator::printStatistics(void)
+{
+    std::cout << std::dec << "Device memory allocations: " << m_deviceAllocationCount << std::endl;
+
+    for (uint32_t i = 0u; i < m_pools.size(); i++)
+    {
+        if (m_pools[i].empty())
+        {
+            continue;
+        }
+
+        MemoryStatistics statistics = getStatistics(i);
+        std::cout << "Memory type " << i
+                  << ": blocks " << statistics.blockCount
+                  << ", allocations " << statistics.allocationCount
+                  << ", used " << statistics.usedBytes << "/" << statistics.reservedBytes << " B"
+                  << ", free ranges " << statistics.freeRangeCount
+                  << ", largest free " << statistics.largestFreeRange << " B"
+                  << ", fragmentation " << statistics.fragmentation << std::endl;
+    }
+}
+
+void DeviceMemoryAllocator::destroy(void)
+{
+    for (auto & pool : m_pools)
+    {
+        for (auto & block : pool)
+        {
+            vkFreeMemory(m_device, block.memory, nullptr);
+        }
+        pool.clear();
+    }
+    m_deviceAllocationCount = 0u;
+}
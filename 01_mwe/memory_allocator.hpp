@@ -0,0 +1,80 @@
+#include <vector>
+#include <mutex>
+
+#include <vulkan/vulkan.h>
+
+#ifndef MEMORY_ALLOCATOR_GUARD
+#define MEMORY_ALLOCATOR_GUARD
+
+#define DEFAULT_MEMORY_BLOCK_SIZE   (64ull * 1024ull * 1024ull)
+
+typedef enum
+{
+    SUBALLOCATION_FREE,
+    SUBALLOCATION_LINEAR,       /* buffers and linearly tiled images */
+    SUBALLOCATION_OPTIMAL       /* optimally tiled images */
+} eSuballocationType;
+
+/* Piece of a large VkDeviceMemory block handed out to a single resource */
+struct MemoryAllocation
+{
+    VkDeviceMemory  memory      = VK_NULL_HANDLE;
+    VkDeviceSize    offset      = 0u;
+    VkDeviceSize    size        = 0u;
+    uint32_t        memoryType  = 0u;
+    uint32_t        block       = 0u;
+    void *          mapped      = nullptr;  /* only for host visible memory types */
+};
+
+struct MemoryStatistics
+{
+    uint32_t        blockCount;
+    uint32_t        allocationCount;
+    uint32_t        freeRangeCount;
+    VkDeviceSize    reservedBytes;
+    VkDeviceSize    usedBytes;
+    VkDeviceSize    largestFreeRange;
+    float           fragmentation;          /* 0 = all free space in one range, towards 1 = scattered */
+};
+
+class DeviceMemoryAllocator
+{
+    private:
+        struct Suballocation
+        {
+            VkDeviceSize        offset;
+            VkDeviceSize        size;
+            eSuballocationType  type;
+        };
+
+        struct Block
+        {
+            VkDeviceMemory              memory;
+            VkDeviceSize                size;
+            void *                      mapped;
+            std::vector<Suballocation>  suballocations;    /* sorted by offset, neighbouring free ranges always merged */
+        };
+
+        VkDevice                            m_device = VK_NULL_HANDLE;
+        VkPhysicalDeviceMemoryProperties    m_memoryProperties;
+        VkDeviceSize                        m_bufferImageGranularity = 1u;
+        VkDeviceSize                        m_preferredBlockSize = DEFAULT_MEMORY_BLOCK_SIZE;
+        uint32_t                            m_deviceAllocationCount = 0u;
+        std::vector<std::vector<Block>>     m_pools;    /* one pool per memory type */
+        std::mutex                          m_mutex;    /* resources are created from several initialization tasks at once */
+
+        uint32_t createBlock(uint32_t memoryType, VkDeviceSize size);
+        bool tryAllocate(Block & block, VkDeviceSize size, VkDeviceSize alignment, eSuballocationType type, VkDeviceSize & offset);
+
+    public:
+        void init(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize preferredBlockSize = DEFAULT_MEMORY_BLOCK_SIZE);
+
+        MemoryAllocation allocate(const VkMemoryRequirements & requirements, uint32_t memoryType, eSuballocationType type);
+        void free(MemoryAllocation & allocation);
+
+        MemoryStatistics getStatistics(uint32_t memoryType);
+        void printStatistics(void);
+
+        void destroy(void);
+};
+#endif
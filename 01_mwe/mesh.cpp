@@ -0,0 +1,337 @@
+#include <iostream>
+#include <cmath>
+#include <cstring>
+#include "mesh.hpp"
+
+/* Forsyth's "Linear-Speed Vertex Cache Optimisation" tuning values */
+#define FORSYTH_CACHE_SIZE          32u
+#define FORSYTH_CACHE_DECAY_POWER   1.5f
+#define FORSYTH_LAST_TRI_SCORE      0.75f
+#define FORSYTH_VALENCE_BOOST_SCALE 2.0f
+#define FORSYTH_VALENCE_BOOST_POWER 0.5f
+
+static uint32_t hashBytes(const uint8_t * data, uint32_t size)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0u; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t generateVertexRemap(const void * vertices, uint32_t vertexCount, uint32_t stride, std::vector<uint32_t> & remap)
+{
+    const uint8_t * data = static_cast<const uint8_t *>(vertices);
+
+    size_t tableSize = 1u;
+    while (tableSize < (2u * (size_t) vertexCount))
+    {
+        tableSize <<= 1u;
+    }
+
+    /* Open addressing, each slot holds the first occurrence of a unique vertex */
+    std::vector<uint32_t> table(tableSize, UINT32_MAX);
+    uint32_t uniqueCount = 0u;
+
+    remap.assign(vertexCount, UINT32_MAX);
+
+    for (uint32_t i = 0u; i < vertexCount; i++)
+    {
+        const uint8_t * vertex = data + (size_t) i * stride;
+        size_t slot = hashBytes(vertex, stride) & (tableSize - 1u);
+
+        while ((UINT32_MAX != table[slot]) && (0 != memcmp(data + (size_t) table[slot] * stride, vertex, stride)))
+        {
+            slot = (slot + 1u) & (tableSize - 1u);
+        }
+
+        if (UINT32_MAX == table[slot])
+        {
+            table[slot] = i;
+            remap[i] = uniqueCount++;
+        }
+        else
+        {
+            remap[i] = remap[table[slot]];
+        }
+    }
+
+    return uniqueCount;
+}
+
+static float vertexScore(int32_t cachePosition, uint32_t liveTriangles)
+{
+    if (0u == liveTriangles)
+    {
+        return -1.f;
+    }
+
+    float score = 0.f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            /* Vertices of the last triangle get a fixed score, otherwise the same triangle would win again */
+            score = FORSYTH_LAST_TRI_SCORE;
+        }
+        else
+        {
+            float scaler = 1.f / (FORSYTH_CACHE_SIZE - 3u);
+            score = powf(1.f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+
+    /* Prefer vertices with few triangles left, finishing them frees cache slots */
+    score += FORSYTH_VALENCE_BOOST_SCALE * powf((float) liveTriangles, -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+void optimizeVertexCache(std::vector<uint32_t> & indices, uint32_t vertexCount)
+{
+    uint32_t triangleCount = (uint32_t) (indices.size() / 3u);
+    if (0u == triangleCount)
+    {
+        return;
+    }
+
+    /* Vertex -> triangle adjacency, the live triangles of vertex v are adjacency[offsets[v] .. offsets[v] + liveTriangles[v]) */
+    std::vector<uint32_t> liveTriangles(vertexCount, 0u);
+    for (auto index : indices)
+    {
+        liveTriangles[index]++;
+    }
+
+    std::vector<uint32_t> offsets(vertexCount, 0u);
+    for (uint32_t v = 1u; v < vertexCount; v++)
+    {
+        offsets[v] = offsets[v - 1u] + liveTriangles[v - 1u];
+    }
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets);
+    for (uint32_t t = 0u; t < triangleCount; t++)
+    {
+        for (uint32_t k = 0u; k < 3u; k++)
+        {
+            adjacency[fill[indices[3u * t + k]]++] = t;
+        }
+    }
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0u; v < vertexCount; v++)
+    {
+        vertexScores[v] = vertexScore(-1, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32_t bestTriangle = 0u;
+    for (uint32_t t = 0u; t < triangleCount; t++)
+    {
+        triangleScores[t] = vertexScores[indices[3u * t]] + vertexScores[indices[3u * t + 1u]] + vertexScores[indices[3u * t + 2u]];
+        if (triangleScores[t] > triangleScores[bestTriangle])
+        {
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3u);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3u);
+
+    uint32_t scanCursor = 0u;
+
+    for (uint32_t emittedCount = 0u; emittedCount < triangleCount; emittedCount++)
+    {
+        if (UINT32_MAX == bestTriangle)
+        {
+            /* Dead end, nothing in the cache touches a live triangle, continue with the next one in input order */
+            while (emitted[scanCursor])
+            {
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+        }
+
+        const uint32_t * triangle = &indices[3u * bestTriangle];
+        emitted[bestTriangle] = true;
+
+        newCache.clear();
+        for (uint32_t k = 0u; k < 3u; k++)
+        {
+            uint32_t v = triangle[k];
+            output.push_back(v);
+            newCache.push_back(v);
+
+            /* Drop the emitted triangle from the vertex's live list */
+            uint32_t * live = &adjacency[offsets[v]];
+            for (uint32_t j = 0u; j < liveTriangles[v]; j++)
+            {
+                if (live[j] == bestTriangle)
+                {
+                    live[j] = live[liveTriangles[v] - 1u];
+                    liveTriangles[v]--;
+                    break;
+                }
+            }
+        }
+
+        for (auto v : cache)
+        {
+            if ((v != triangle[0]) && (v != triangle[1]) && (v != triangle[2]))
+            {
+                newCache.push_back(v);
+            }
+        }
+
+        /* Rescore everything that was or is in the cache, and pick the best triangle among their neighbours */
+        for (uint32_t i = 0u; i < newCache.size(); i++)
+        {
+            uint32_t v = newCache[i];
+            cachePosition[v] = (i < FORSYTH_CACHE_SIZE) ? (int32_t) i : -1;
+            vertexScores[v] = vertexScore(cachePosition[v], liveTriangles[v]);
+        }
+
+        bestTriangle = UINT32_MAX;
+        float bestScore = -1.f;
+        for (uint32_t i = 0u; i < newCache.size(); i++)
+        {
+            uint32_t v = newCache[i];
+            for (uint32_t j = 0u; j < liveTriangles[v]; j++)
+            {
+                uint32_t t = adjacency[offsets[v] + j];
+                triangleScores[t] = vertexScores[indices[3u * t]] + vertexScores[indices[3u * t + 1u]] + vertexScores[indices[3u * t + 2u]];
+                if (triangleScores[t] > bestScore)
+                {
+                    bestScore = triangleScores[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE)
+        {
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(newCache);
+    }
+
+    indices.swap(output);
+}
+
+uint32_t optimizeVertexFetch(std::vector<uint8_t> & vertexData, uint32_t vertexCount, uint32_t stride, std::vector<uint32_t> & indices)
+{
+    /* Store vertices in the order the index buffer first touches them */
+    std::vector<uint32_t> newIndex(vertexCount, UINT32_MAX);
+    std::vector<uint8_t> reordered(vertexData.size());
+    uint32_t nextVertex = 0u;
+
+    for (auto & index : indices)
+    {
+        if (UINT32_MAX == newIndex[index])
+        {
+            newIndex[index] = nextVertex;
+            memcpy(&reordered[(size_t) nextVertex * stride], &vertexData[(size_t) index * stride], stride);
+            nextVertex++;
+        }
+        index = newIndex[index];
+    }
+
+    /* Unreferenced vertices are dropped */
+    reordered.resize((size_t) nextVertex * stride);
+    vertexData.swap(reordered);
+
+    return nextVertex;
+}
+
+float computeACMR(const std::vector<uint32_t> & indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    if (indices.size() < 3u)
+    {
+        return 0.f;
+    }
+
+    /* FIFO cache simulation, a vertex is a hit while fewer than cacheSize misses happened since it was loaded */
+    std::vector<uint32_t> loadedAt(vertexCount, 0u);
+    uint32_t clock = cacheSize + 1u;
+    uint32_t misses = 0u;
+
+    for (auto index : indices)
+    {
+        if ((clock - loadedAt[index]) > cacheSize)
+        {
+            loadedAt[index] = clock++;
+            misses++;
+        }
+    }
+
+    return (float) misses / (float) (indices.size() / 3u);
+}
+
+IndexedMesh preprocessMesh(const void * vertices, uint32_t vertexCount, uint32_t stride)
+{
+    IndexedMesh mesh;
+    std::vector<uint32_t> remap;
+    const uint8_t * data = static_cast<const uint8_t *>(vertices);
+
+    mesh.vertexStride = stride;
+    mesh.vertexCount = generateVertexRemap(vertices, vertexCount, stride, remap);
+    mesh.vertexData.resize((size_t) mesh.vertexCount * stride);
+    mesh.indices.resize(vertexCount);
+
+    for (uint32_t i = 0u; i < vertexCount; i++)
+    {
+        mesh.indices[i] = remap[i];
+        memcpy(&mesh.vertexData[(size_t) remap[i] * stride], data + (size_t) i * stride, stride);
+    }
+
+    /* A non-indexed draw shades every corner of every triangle */
+    float acmrSoup = 3.f;
+    float acmrIndexed = computeACMR(mesh.indices, mesh.vertexCount, VERTEX_CACHE_SIZE);
+
+    optimizeVertexCache(mesh.indices, mesh.vertexCount);
+    mesh.vertexCount = optimizeVertexFetch(mesh.vertexData, mesh.vertexCount, stride, mesh.indices);
+
+    float acmrOptimized = computeACMR(mesh.indices, mesh.vertexCount, VERTEX_CACHE_SIZE);
+
+    std::cout << std::dec << "Mesh: " << vertexCount << " soup vertices -> " << mesh.vertexCount << " unique, "
+              << (mesh.indices.size() / 3u) << " triangles" << std::endl;
+    std::cout << "ACMR (FIFO " << VERTEX_CACHE_SIZE << "): soup " << acmrSoup << ", indexed " << acmrIndexed
+              << ", optimized " << acmrOptimized << std::endl;
+
+    return mesh;
+}
+
+VkIndexType selectIndexType(uint32_t vertexCount)
+{
+    return (vertexCount <= 65536u) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
+
+std::vector<uint8_t> packIndices(const std::vector<uint32_t> & indices, VkIndexType indexType)
+{
+    std::vector<uint8_t> packed;
+
+    if (VK_INDEX_TYPE_UINT16 == indexType)
+    {
+        packed.resize(indices.size() * sizeof(uint16_t));
+        uint16_t * out = reinterpret_cast<uint16_t *>(packed.data());
+        for (size_t i = 0u; i < indices.size(); i++)
+        {
+            out[i] = (uint16_t) indices[i];
+        }
+    }
+    else
+    {
+        packed.resize(indices.size() * sizeof(uint32_t));
+        memcpy(packed.data(), indices.data(), packed.size());
+    }
+
+    return packed;
+}
@@ -0,0 +1,30 @@
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#ifndef MESH_GUARD
+#define MESH_GUARD
+
+/* Size of the FIFO post-transform cache used to report ACMR */
+#define VERTEX_CACHE_SIZE   16u
+
+/* Indexed mesh, vertices are kept as raw bytes so any vertex layout can be processed */
+struct IndexedMesh
+{
+    std::vector<uint8_t>    vertexData;
+    uint32_t                vertexCount;
+    uint32_t                vertexStride;
+    std::vector<uint32_t>   indices;
+};
+
+uint32_t generateVertexRemap(const void * vertices, uint32_t vertexCount, uint32_t stride, std::vector<uint32_t> & remap);
+void optimizeVertexCache(std::vector<uint32_t> & indices, uint32_t vertexCount);
+uint32_t optimizeVertexFetch(std::vector<uint8_t> & vertexData, uint32_t vertexCount, uint32_t stride, std::vector<uint32_t> & indices);
+float computeACMR(const std::vector<uint32_t> & indices, uint32_t vertexCount, uint32_t cacheSize);
+
+IndexedMesh preprocessMesh(const void * vertices, uint32_t vertexCount, uint32_t stride);
+
+VkIndexType selectIndexType(uint32_t vertexCount);
+std::vector<uint8_t> packIndices(const std::vector<uint32_t> & indices, VkIndexType indexType);
+#endif
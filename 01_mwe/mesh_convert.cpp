@@ -0,0 +1,410 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include "vertex_format.hpp"
+#include "mesh.hpp"
+#include "mesh_file.hpp"
+#include "glm/glm/glm.hpp"
+
+/*
+ * Offline converter: OBJ or PLY -> binary mesh file (mesh_file.hpp) in the vertex format of this build.
+ * All preprocessing (triangulation, deduplication, cache and fetch optimization, encoding) happens here,
+ * so the runtime only maps the file and copies its sections.
+ */
+
+static bool isBlank(char c)
+{
+    return (' ' == c) || ('\t' == c) || ('\r' == c);
+}
+
+static const char * skipBlanks(const char * p)
+{
+    while (isBlank(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char * skipLine(const char * p)
+{
+    while (('\0' != *p) && ('\n' != *p))
+    {
+        p++;
+    }
+    return ('\0' != *p) ? (p + 1) : p;
+}
+
+/* Polygons are split into triangle fans, corners are copied into the triangle soup */
+static void addPolygon(const std::vector<glm::vec4> & positions, const std::vector<glm::vec4> & colors,
+                       const std::vector<uint32_t> & polygon, std::vector<Vertex> & soup)
+{
+    for (size_t k = 1u; (k + 1u) < polygon.size(); k++)
+    {
+        for (uint32_t corner : {polygon[0u], polygon[k], polygon[k + 1u]})
+        {
+            if (corner >= positions.size())
+            {
+                throw std::runtime_error("Face references a missing vertex!");
+            }
+            soup.push_back({positions[corner], colors[corner]});
+        }
+    }
+}
+
+/* v x y z [r g b] and f with v, v/vt, v//vn or v/vt/vn corners, negative indices count from the end */
+static void parseObj(const char * text, std::vector<Vertex> & soup)
+{
+    std::vector<glm::vec4> positions;
+    std::vector<glm::vec4> colors;
+    std::vector<uint32_t> polygon;
+
+    for (const char * p = text; '\0' != *p; p = skipLine(p))
+    {
+        p = skipBlanks(p);
+        if (('v' == p[0]) && isBlank(p[1]))
+        {
+            float values[6];
+            uint32_t count = 0u;
+            for (p = skipBlanks(p + 1); (count < 6u) && ('\n' != *p) && ('\0' != *p); p = skipBlanks(p))
+            {
+                char * end;
+                values[count] = strtof(p, &end);
+                if (end == p)
+                {
+                    break;
+                }
+                count++;
+                p = end;
+            }
+            if (count < 3u)
+            {
+                throw std::runtime_error("Invalid OBJ vertex!");
+            }
+            positions.push_back(glm::vec4(values[0], values[1], values[2], 1.f));
+            colors.push_back((6u == count) ? glm::vec4(values[3], values[4], values[5], 1.f) : glm::vec4(1.f));
+        }
+        else if (('f' == p[0]) && isBlank(p[1]))
+        {
+            polygon.clear();
+            for (p = skipBlanks(p + 1); ('\n' != *p) && ('\0' != *p); p = skipBlanks(p))
+            {
+                char * end;
+                long index = strtol(p, &end, 10);
+                if ((end == p) || (0 == index))
+                {
+                    throw std::runtime_error("Invalid OBJ face!");
+                }
+                /* Texture coordinate and normal indices are not used */
+                for (p = end; !isBlank(*p) && ('\n' != *p) && ('\0' != *p); p++)
+                {
+                }
+                polygon.push_back((index > 0) ? (uint32_t) (index - 1) : (uint32_t) ((long) positions.size() + index));
+            }
+            addPolygon(positions, colors, polygon, soup);
+        }
+    }
+}
+
+typedef enum
+{
+    PLY_ASCII,
+    PLY_BINARY_LITTLE_ENDIAN,
+    PLY_BINARY_BIG_ENDIAN
+} ePlyFormat;
+
+struct PlyProperty
+{
+    std::string name;
+    std::string type;
+    std::string countType;      /* only set for list properties */
+};
+
+struct PlyElement
+{
+    std::string                 name;
+    uint64_t                    count;
+    std::vector<PlyProperty>    properties;
+};
+
+class PlyReader
+{
+    private:
+        const char *    m_cursor;
+        const char *    m_end;
+        ePlyFormat      m_format;
+
+    public:
+        PlyReader(const char * data, const char * end, ePlyFormat format) : m_cursor(data), m_end(end), m_format(format) {}
+
+        double read(const std::string & type)
+        {
+            if (PLY_ASCII == m_format)
+            {
+                char * end;
+                double value = strtod(m_cursor, &end);
+                if (end == m_cursor)
+                {
+                    throw std::runtime_error("Truncated PLY data!");
+                }
+                m_cursor = end;
+                return value;
+            }
+
+            size_t size = (("char" == type) || ("uchar" == type) || ("int8" == type) || ("uint8" == type)) ? 1u :
+                          (("short" == type) || ("ushort" == type) || ("int16" == type) || ("uint16" == type)) ? 2u :
+                          (("double" == type) || ("float64" == type)) ? 8u : 4u;
+            if ((size_t) (m_end - m_cursor) < size)
+            {
+                throw std::runtime_error("Truncated PLY data!");
+            }
+
+            uint8_t bytes[8];
+            memcpy(bytes, m_cursor, size);
+            m_cursor += size;
+            if (PLY_BINARY_BIG_ENDIAN == m_format)
+            {
+                std::reverse(bytes, bytes + size);
+            }
+
+            if (("char" == type) || ("int8" == type))        { int8_t v;   memcpy(&v, bytes, size); return v; }
+            if (("uchar" == type) || ("uint8" == type))      { uint8_t v;  memcpy(&v, bytes, size); return v; }
+            if (("short" == type) || ("int16" == type))      { int16_t v;  memcpy(&v, bytes, size); return v; }
+            if (("ushort" == type) || ("uint16" == type))    { uint16_t v; memcpy(&v, bytes, size); return v; }
+            if (("int" == type) || ("int32" == type))        { int32_t v;  memcpy(&v, bytes, size); return v; }
+            if (("uint" == type) || ("uint32" == type))      { uint32_t v; memcpy(&v, bytes, size); return v; }
+            if (("float" == type) || ("float32" == type))    { float v;    memcpy(&v, bytes, size); return v; }
+            if (("double" == type) || ("float64" == type))   { double v;   memcpy(&v, bytes, size); return v; }
+            throw std::runtime_error("Unknown PLY property type!");
+        }
+};
+
+/* Vertices with x, y, z and optional red, green, blue (8 bit or float), faces with a vertex_indices list */
+static void parsePly(const char * text, size_t size, std::vector<Vertex> & soup)
+{
+    ePlyFormat format = PLY_ASCII;
+    std::vector<PlyElement> elements;
+    const char * p = text;
+
+    if (0 != strncmp(p, "ply", 3))
+    {
+        throw std::runtime_error("Not a PLY file!");
+    }
+
+    for (p = skipLine(p); ; p = skipLine(p))
+    {
+        if ('\0' == *p)
+        {
+            throw std::runtime_error("PLY header has no end_header!");
+        }
+
+        const char * lineEnd = skipLine(p);
+        std::string line(p, lineEnd);
+        char word[32] = {};
+        char a[32] = {};
+        char b[32] = {};
+        char c[32] = {};
+        char d[64] = {};
+        int fields = sscanf(line.c_str(), "%31s %31s %31s %31s %63s", word, a, b, c, d);
+
+        if (0 == strcmp(word, "end_header"))
+        {
+            p = lineEnd;
+            break;
+        }
+        else if ((0 == strcmp(word, "format")) && (fields >= 2))
+        {
+            format = (0 == strcmp(a, "binary_little_endian")) ? PLY_BINARY_LITTLE_ENDIAN :
+                     (0 == strcmp(a, "binary_big_endian")) ? PLY_BINARY_BIG_ENDIAN : PLY_ASCII;
+        }
+        else if ((0 == strcmp(word, "element")) && (3 == fields))
+        {
+            elements.push_back({a, strtoull(b, nullptr, 10), {}});
+        }
+        else if ((0 == strcmp(word, "property")) && !elements.empty())
+        {
+            if ((0 == strcmp(a, "list")) && (5 == fields))
+            {
+                /* property list <count type> <item type> <name> */
+                elements.back().properties.push_back({d, c, b});
+            }
+            else if (3 == fields)
+            {
+                elements.back().properties.push_back({b, a, ""});
+            }
+        }
+    }
+
+    std::vector<glm::vec4> positions;
+    std::vector<glm::vec4> colors;
+    std::vector<uint32_t> polygon;
+    PlyReader reader(p, text + size, format);
+
+    for (const auto & element : elements)
+    {
+        bool vertices = ("vertex" == element.name);
+        bool faces = ("face" == element.name);
+
+        for (uint64_t i = 0u; i < element.count; i++)
+        {
+            glm::vec4 position(0.f, 0.f, 0.f, 1.f);
+            glm::vec4 color(1.f);
+            polygon.clear();
+
+            for (const auto & property : element.properties)
+            {
+                if (!property.countType.empty())
+                {
+                    uint32_t count = (uint32_t) reader.read(property.countType);
+                    bool indices = faces && (("vertex_indices" == property.name) || ("vertex_index" == property.name));
+                    for (uint32_t k = 0u; k < count; k++)
+                    {
+                        double value = reader.read(property.type);
+                        if (indices)
+                        {
+                            polygon.push_back((uint32_t) value);
+                        }
+                    }
+                    continue;
+                }
+
+                double value = reader.read(property.type);
+                bool normalized = ("uchar" == property.type) || ("uint8" == property.type);
+                float channel = (float) (normalized ? (value / 255.0) : value);
+                if (vertices)
+                {
+                    if ("x" == property.name)           position.x = (float) value;
+                    else if ("y" == property.name)      position.y = (float) value;
+                    else if ("z" == property.name)      position.z = (float) value;
+                    else if ("red" == property.name)    color.r = channel;
+                    else if ("green" == property.name)  color.g = channel;
+                    else if ("blue" == property.name)   color.b = channel;
+                    else if ("alpha" == property.name)  color.a = channel;
+                }
+            }
+
+            if (vertices)
+            {
+                positions.push_back(position);
+                colors.push_back(color);
+            }
+            else if (faces)
+            {
+                addPolygon(positions, colors, polygon, soup);
+            }
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "Usage: " << argv[0] << " <input.obj|input.ply> <output.mesh>" << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::string inputPath = argv[1];
+        std::string outputPath = argv[2];
+
+        /* Terminated copy of the input, the parsers use strtof/strtol */
+        std::ifstream input(inputPath, std::ios::binary);
+        if (!input.is_open())
+        {
+            throw std::runtime_error("Unable to open input file!");
+        }
+        std::vector<char> text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        size_t textSize = text.size();
+        text.push_back('\0');
+        input.close();
+
+        std::vector<Vertex> soup;
+        std::string extension = inputPath.substr(inputPath.find_last_of('.') + 1u);
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if ("ply" == extension)
+        {
+            parsePly(text.data(), textSize, soup);
+        }
+        else
+        {
+            parseObj(text.data(), soup);
+        }
+        text = std::vector<char>();
+
+        if (soup.empty() || (soup.size() > UINT32_MAX))
+        {
+            throw std::runtime_error("Mesh has no triangles or is too large!");
+        }
+
+        /* Bounds in model units, the snorm layout normalizes positions by the largest coordinate */
+        glm::vec3 boundsMin(soup[0].coord.x, soup[0].coord.y, soup[0].coord.z);
+        glm::vec3 boundsMax = boundsMin;
+        for (const auto & vertex : soup)
+        {
+            glm::vec3 coord(vertex.coord.x, vertex.coord.y, vertex.coord.z);
+            boundsMin = glm::min(boundsMin, coord);
+            boundsMax = glm::max(boundsMax, coord);
+        }
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float radius = 0.f;
+        float maxCoord = 0.f;
+        for (const auto & vertex : soup)
+        {
+            glm::vec3 coord(vertex.coord.x, vertex.coord.y, vertex.coord.z);
+            radius = std::max(radius, glm::length(coord - center));
+            maxCoord = std::max(maxCoord, std::max(fabsf(coord.x), std::max(fabsf(coord.y), fabsf(coord.z))));
+        }
+        float positionScale = (VertexFormatTraits<GpuVertex>::normalizedCoord && (maxCoord > 0.f)) ? maxCoord : 1.f;
+
+        std::vector<GpuVertex> gpuVertices(soup.size());
+        for (size_t i = 0u; i < soup.size(); i++)
+        {
+            gpuVertices[i] = VertexFormatTraits<GpuVertex>::encode(soup[i], 1.f / positionScale);
+        }
+        soup = std::vector<Vertex>();
+
+        IndexedMesh mesh = preprocessMesh(gpuVertices.data(), (uint32_t) gpuVertices.size(), sizeof(GpuVertex));
+        VkIndexType indexType = selectIndexType(mesh.vertexCount);
+        std::vector<uint8_t> indexData = packIndices(mesh.indices, indexType);
+
+        MeshFileHeader header = {};
+        header.vertexFormat = VERTEX_FORMAT;
+        header.vertexStride = sizeof(GpuVertex);
+        header.vertexCount = mesh.vertexCount;
+        header.indexSize = (VK_INDEX_TYPE_UINT16 == indexType) ? 2u : 4u;
+        header.indexCount = (uint32_t) mesh.indices.size();
+        for (uint32_t k = 0u; k < 3u; k++)
+        {
+            header.boundsMin[k] = boundsMin[k];
+            header.boundsMax[k] = boundsMax[k];
+            header.sphere[k] = center[k];
+        }
+        header.sphere[3] = radius;
+        header.positionScale = positionScale;
+
+        writeMeshFile(outputPath, header, mesh.vertexData.data(), indexData.data());
+
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        std::cout << "Wrote " << outputPath << ": " << header.vertexCount << " vertices (" << VertexFormatTraits<GpuVertex>::name << "), "
+                  << (header.indexCount / 3u) << " triangles, " << (header.indexOffset + header.indexBytes) << " B in " << duration.count() << " ms" << std::endl;
+    }
+    catch (const std::exception & exception)
+    {
+        std::cout << "Conversion failed: " << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
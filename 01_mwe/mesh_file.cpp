@@ -0,0 +1,109 @@
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "mesh_file.hpp"
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + MESH_FILE_ALIGNMENT - 1u) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+void writeMeshFile(const std::string & path, MeshFileHeader & header, const void * vertexData, const void * indexData)
+{
+    memset(header.magic, 0, sizeof(header.magic));
+    memcpy(header.magic, MESH_FILE_MAGIC, sizeof(MESH_FILE_MAGIC));
+    header.version = MESH_FILE_VERSION;
+    header.vertexBytes = (uint64_t) header.vertexCount * header.vertexStride;
+    header.indexBytes = (uint64_t) header.indexCount * header.indexSize;
+    header.vertexOffset = alignOffset(sizeof(MeshFileHeader));
+    header.indexOffset = alignOffset(header.vertexOffset + header.vertexBytes);
+
+    /* Written to a temporary file first, a failed conversion must not leave a truncated mesh behind */
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Unable to write mesh file!");
+    }
+
+    std::vector<char> padding(MESH_FILE_ALIGNMENT, 0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(padding.data(), (std::streamsize) (header.vertexOffset - sizeof(header)));
+    file.write(static_cast<const char *>(vertexData), (std::streamsize) header.vertexBytes);
+    file.write(padding.data(), (std::streamsize) (header.indexOffset - header.vertexOffset - header.vertexBytes));
+    file.write(static_cast<const char *>(indexData), (std::streamsize) header.indexBytes);
+    file.close();
+    if (file.fail())
+    {
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Unable to write mesh file!");
+    }
+
+    std::remove(path.c_str());
+    std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+uint32_t findMaxIndex(const uint8_t * indices, uint32_t indexSize, size_t count)
+{
+    /* The mapping gives no alignment guarantee beyond the section's, copy every index out */
+    uint32_t maxIndex = 0u;
+    for (size_t i = 0u; i < count; i++)
+    {
+        uint32_t index;
+        if (2u == indexSize)
+        {
+            uint16_t index16;
+            memcpy(&index16, indices + i * 2u, sizeof(index16));
+            index = index16;
+        }
+        else
+        {
+            memcpy(&index, indices + i * 4u, sizeof(index));
+        }
+        maxIndex = (index > maxIndex) ? index : maxIndex;
+    }
+    return maxIndex;
+}
+
+void MeshFile::open(const std::string & path)
+{
+    release();
+    m_file.map(path);
+
+    /* Only the header is touched here, the sections are paged in while they are streamed to the GPU */
+    size_t size = m_file.size();
+    m_header = reinterpret_cast<const MeshFileHeader *>(m_file.data());
+    if ((size < sizeof(MeshFileHeader)) || (0 != memcmp(m_header->magic, MESH_FILE_MAGIC, sizeof(MESH_FILE_MAGIC))))
+    {
+        release();
+        throw std::runtime_error("Not a mesh file!");
+    }
+
+    /* Empty sections would become zero sized buffers, the converter never writes a mesh without triangles */
+    const MeshFileHeader & header = *m_header;
+    bool valid = (MESH_FILE_VERSION == header.version) &&
+                 (0u != header.vertexCount) && (0u != header.vertexStride) && (0u != header.indexCount) &&
+                 ((2u == header.indexSize) || (4u == header.indexSize)) &&
+                 (header.vertexBytes == (uint64_t) header.vertexCount * header.vertexStride) &&
+                 (header.indexBytes == (uint64_t) header.indexCount * header.indexSize) &&
+                 (0u == (header.indexCount % 3u)) &&
+                 (header.positionScale > 0.f) && std::isfinite(header.positionScale) &&
+                 (header.vertexOffset >= sizeof(MeshFileHeader)) && (header.vertexOffset <= size) && (header.vertexBytes <= size - header.vertexOffset) &&
+                 (header.indexOffset >= header.vertexOffset + header.vertexBytes) && (header.indexOffset <= size) && (header.indexBytes <= size - header.indexOffset);
+    if (!valid)
+    {
+        release();
+        throw std::runtime_error("Unsupported or corrupt mesh file!");
+    }
+
+    m_file.adviseSequential();
+}
+
+void MeshFile::release(void)
+{
+    m_file.release();
+    m_header = nullptr;
+}
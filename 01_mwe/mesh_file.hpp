@@ -0,0 +1,65 @@
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "mapped_file.hpp"
+
+#ifndef MESH_FILE_GUARD
+#define MESH_FILE_GUARD
+
+#define MESH_FILE_MAGIC         "MWEMESH"
+#define MESH_FILE_VERSION       1u
+#define MESH_FILE_ALIGNMENT     256u        /* every section starts at a multiple of this */
+
+/*
+ * Binary mesh container written by example_mesh_convert:
+ *  header | vertex section | index section
+ * Vertices are stored in the GPU layout of the build (deduplicated, cache and fetch optimized), indices packed
+ * as uint16 or uint32, so both sections are copied into staging memory straight from the mapping.
+ */
+struct MeshFileHeader
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    vertexFormat;       /* VERTEX_FORMAT_* the vertex section was encoded with */
+    uint32_t    vertexStride;
+    uint32_t    vertexCount;
+    uint32_t    indexSize;          /* 2 or 4 bytes */
+    uint32_t    indexCount;
+    uint64_t    vertexOffset;       /* bytes from the start of the file */
+    uint64_t    vertexBytes;
+    uint64_t    indexOffset;
+    uint64_t    indexBytes;
+    float       boundsMin[4];       /* model units */
+    float       boundsMax[4];
+    float       sphere[4];          /* xyz center, w radius, model units */
+    float       positionScale;      /* encoded positions are model positions / positionScale */
+    uint32_t    reserved[3];
+};
+
+static_assert(128u == sizeof(MeshFileHeader), "MeshFileHeader layout changed");
+
+/* Fills in magic, version and the section offsets of the header */
+void writeMeshFile(const std::string & path, MeshFileHeader & header, const void * vertexData, const void * indexData);
+
+/* Largest of count packed uint16 or uint32 indices, every index has to address a vertex of the file */
+uint32_t findMaxIndex(const uint8_t * indices, uint32_t indexSize, size_t count);
+
+/* Memory-mapped mesh file, validated on open; section pointers stay valid until release() */
+class MeshFile
+{
+    private:
+        MappedFile                  m_file;
+        const MeshFileHeader *      m_header = nullptr;
+
+    public:
+        void open(const std::string & path);
+
+        const MeshFileHeader & header(void) { return *m_header; }
+        const uint8_t * vertexData(void) { return m_file.data() + m_header->vertexOffset; }
+        const uint8_t * indexData(void) { return m_file.data() + m_header->indexOffset; }
+        MappedFile & file(void) { return m_file; }
+
+        void release(void);
+};
+#endif
@@ -0,0 +1,292 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include "profiler.hpp"
+
+static const char * cpuTimerNames[CPU_TIMER_COUNT] = {"fence_wait_ms", "acquire_ms", "record_ms", "submit_ms", "present_ms"};
+
+void FrameProfiler::init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t timestampValidBits, uint32_t frameSlots,
+                         bool pipelineStatistics, const std::string & outputPath)
+{
+    VkResult result;
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    m_device = device;
+    m_enabled = true;
+    m_outputPath = outputPath;
+    m_timestampPeriod = properties.limits.timestampPeriod;
+    m_timestampMask = (timestampValidBits >= 64u) ? UINT64_MAX : ((1ull << timestampValidBits) - 1u);
+
+    /* Two timestamps per frame slot, queue families without valid bits cannot write timestamps */
+    if (0u != timestampValidBits)
+    {
+        VkQueryPoolCreateInfo qpci =
+        {
+            .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext              = nullptr,
+            .flags              = 0,
+            .queryType          = VK_QUERY_TYPE_TIMESTAMP,
+            .queryCount         = 2u * frameSlots,
+            .pipelineStatistics = 0,
+        };
+        result = vkCreateQueryPool(m_device, &qpci, nullptr, &m_timestampPool);
+        if (VK_SUCCESS != result)
+        {
+            m_timestampPool = VK_NULL_HANDLE;
+        }
+    }
+    else
+    {
+        std::cout << "Graphics queue does not support timestamps, GPU times are not available" << std::endl;
+    }
+
+    if (pipelineStatistics)
+    {
+        m_statisticsFlags = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        VkQueryPoolCreateInfo qpci =
+        {
+            .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .pNext              = nullptr,
+            .flags              = 0,
+            .queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+            .queryCount         = frameSlots,
+            .pipelineStatistics = m_statisticsFlags,
+        };
+        result = vkCreateQueryPool(m_device, &qpci, nullptr, &m_statisticsPool);
+        if (VK_SUCCESS != result)
+        {
+            m_statisticsPool = VK_NULL_HANDLE;
+            m_statisticsFlags = 0;
+        }
+    }
+
+    m_pending.resize(frameSlots);
+    m_pendingValid.assign(frameSlots, false);
+}
+
+void FrameProfiler::beginFrame(void)
+{
+    m_current = FrameRecord();
+    m_current.frame = m_frameNumber++;
+    m_current.gpuMs = -1.0;
+    m_frameStart = std::chrono::steady_clock::now();
+}
+
+void FrameProfiler::endFrame(uint32_t slot)
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    m_current.cpuFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_frameStart).count();
+    m_pending[slot] = m_current;
+    m_pendingValid[slot] = true;
+}
+
+void FrameProfiler::resolve(uint32_t slot)
+{
+    if ((!m_enabled) || (!m_pendingValid[slot]))
+    {
+        return;
+    }
+
+    /* The slot's fence is signaled, so no VK_QUERY_RESULT_WAIT_BIT; results that are not there are skipped */
+    FrameRecord & record = m_pending[slot];
+    if (VK_NULL_HANDLE != m_timestampPool)
+    {
+        uint64_t timestamps[2u];
+        if (VK_SUCCESS == vkGetQueryPoolResults(m_device, m_timestampPool, 2u * slot, 2u, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT))
+        {
+            record.gpuMs = (double) ((timestamps[1u] - timestamps[0u]) & m_timestampMask) * m_timestampPeriod / 1000000.0;
+        }
+    }
+
+    if (VK_NULL_HANDLE != m_statisticsPool)
+    {
+        /* Results come in flag bit order, vertex shader invocations first */
+        uint64_t statistics[2u];
+        if (VK_SUCCESS == vkGetQueryPoolResults(m_device, m_statisticsPool, slot, 1u, sizeof(statistics), statistics, sizeof(statistics), VK_QUERY_RESULT_64_BIT))
+        {
+            record.vertexInvocations = statistics[0u];
+            record.fragmentInvocations = statistics[1u];
+        }
+    }
+
+    m_records.push_back(record);
+    m_pendingValid[slot] = false;
+
+    /* Without an export file only the summary window is needed */
+    if (m_outputPath.empty() && (m_records.size() > 2u * PROFILER_WINDOW))
+    {
+        m_records.erase(m_records.begin(), m_records.begin() + PROFILER_WINDOW);
+    }
+
+    if (0u == (m_records.size() % PROFILER_WINDOW))
+    {
+        printSummary();
+    }
+}
+
+void FrameProfiler::cmdBegin(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    /* Queries are reset in the same command buffer, outside of the render pass */
+    if (VK_NULL_HANDLE != m_timestampPool)
+    {
+        vkCmdResetQueryPool(commandBuffer, m_timestampPool, 2u * slot, 2u);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, 2u * slot);
+    }
+    if (VK_NULL_HANDLE != m_statisticsPool)
+    {
+        vkCmdResetQueryPool(commandBuffer, m_statisticsPool, slot, 1u);
+        vkCmdBeginQuery(commandBuffer, m_statisticsPool, slot, 0);
+    }
+}
+
+void FrameProfiler::cmdEnd(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if (!m_enabled)
+    {
+        return;
+    }
+
+    if (VK_NULL_HANDLE != m_statisticsPool)
+    {
+        vkCmdEndQuery(commandBuffer, m_statisticsPool, slot);
+    }
+    if (VK_NULL_HANDLE != m_timestampPool)
+    {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, 2u * slot + 1u);
+    }
+}
+
+static double percentile(std::vector<double> & values, double fraction)
+{
+    size_t index = (size_t) (fraction * (values.size() - 1u) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+void FrameProfiler::printSummary(void)
+{
+    if (m_records.empty())
+    {
+        return;
+    }
+
+    std::vector<double> cpu;
+    std::vector<double> gpu;
+    double vertexInvocations = 0.0;
+    double fragmentInvocations = 0.0;
+    size_t first = (m_records.size() > PROFILER_WINDOW) ? (m_records.size() - PROFILER_WINDOW) : 0u;
+    for (size_t i = first; i < m_records.size(); i++)
+    {
+        cpu.push_back(m_records[i].cpuFrameMs);
+        vertexInvocations += (double) m_records[i].vertexInvocations;
+        fragmentInvocations += (double) m_records[i].fragmentInvocations;
+        if (m_records[i].gpuMs >= 0.0)
+        {
+            gpu.push_back(m_records[i].gpuMs);
+        }
+    }
+
+    std::cout << std::dec << "Last " << cpu.size() << " frames, CPU ms p50/p95/p99: "
+              << percentile(cpu, 0.50) << "/" << percentile(cpu, 0.95) << "/" << percentile(cpu, 0.99);
+    if (!gpu.empty())
+    {
+        std::cout << ", GPU ms p50/p95/p99: " << percentile(gpu, 0.50) << "/" << percentile(gpu, 0.95) << "/" << percentile(gpu, 0.99);
+    }
+    std::cout << std::endl;
+
+    /* Fragment invocations per frame is the overdraw measure, e.g. with and without the depth pre-pass */
+    if (0 != m_statisticsFlags)
+    {
+        std::cout << "Mean invocations per frame, vertex: " << (vertexInvocations / cpu.size())
+                  << ", fragment: " << (fragmentInvocations / cpu.size()) << std::endl;
+    }
+}
+
+void FrameProfiler::exportRecords(void)
+{
+    if ((!m_enabled) || m_outputPath.empty())
+    {
+        return;
+    }
+
+    std::ofstream file(m_outputPath, std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cout << "Unable to write profile " << m_outputPath << std::endl;
+        return;
+    }
+
+    /* JSON when the file name asks for it, CSV otherwise */
+    bool json = (m_outputPath.size() >= 5u) && (0 == m_outputPath.compare(m_outputPath.size() - 5u, 5u, ".json"));
+
+    if (json)
+    {
+        file << "[\n";
+    }
+    else
+    {
+        file << "frame,cpu_frame_ms";
+        for (uint32_t t = 0u; t < CPU_TIMER_COUNT; t++)
+        {
+            file << "," << cpuTimerNames[t];
+        }
+        file << ",gpu_ms,vertex_invocations,fragment_invocations\n";
+    }
+
+    for (size_t i = 0u; i < m_records.size(); i++)
+    {
+        const FrameRecord & record = m_records[i];
+        if (json)
+        {
+            file << "  {\"frame\": " << record.frame << ", \"cpu_frame_ms\": " << record.cpuFrameMs;
+            for (uint32_t t = 0u; t < CPU_TIMER_COUNT; t++)
+            {
+                file << ", \"" << cpuTimerNames[t] << "\": " << record.cpuMs[t];
+            }
+            file << ", \"gpu_ms\": " << record.gpuMs << ", \"vertex_invocations\": " << record.vertexInvocations
+                 << ", \"fragment_invocations\": " << record.fragmentInvocations << "}" << (((i + 1u) < m_records.size()) ? ",\n" : "\n");
+        }
+        else
+        {
+            file << record.frame << "," << record.cpuFrameMs;
+            for (uint32_t t = 0u; t < CPU_TIMER_COUNT; t++)
+            {
+                file << "," << record.cpuMs[t];
+            }
+            file << "," << record.gpuMs << "," << record.vertexInvocations << "," << record.fragmentInvocations << "\n";
+        }
+    }
+
+    if (json)
+    {
+        file << "]\n";
+    }
+
+    std::cout << std::dec << "Profile of " << m_records.size() << " frames written to " << m_outputPath << std::endl;
+}
+
+void FrameProfiler::destroy(void)
+{
+    if (VK_NULL_HANDLE != m_timestampPool)
+    {
+        vkDestroyQueryPool(m_device, m_timestampPool, nullptr);
+    }
+    if (VK_NULL_HANDLE != m_statisticsPool)
+    {
+        vkDestroyQueryPool(m_device, m_statisticsPool, nullptr);
+    }
+    m_timestampPool = VK_NULL_HANDLE;
+    m_statisticsPool = VK_NULL_HANDLE;
+    m_enabled = false;
+}
@@ -0,0 +1,91 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#ifndef PROFILER_GUARD
+#define PROFILER_GUARD
+
+/* Number of most recent frames the percentile summary is computed over */
+#define PROFILER_WINDOW     1000u
+
+/* CPU side phases of a frame */
+typedef enum
+{
+    CPU_TIMER_FENCE_WAIT,
+    CPU_TIMER_ACQUIRE,
+    CPU_TIMER_RECORD,
+    CPU_TIMER_SUBMIT,
+    CPU_TIMER_PRESENT,
+    CPU_TIMER_COUNT
+} eCpuTimer;
+
+struct FrameRecord
+{
+    uint64_t    frame;
+    double      cpuFrameMs;
+    double      cpuMs[CPU_TIMER_COUNT];
+    double      gpuMs;                  /* render pass time from timestamps, negative when not available */
+    uint64_t    vertexInvocations;
+    uint64_t    fragmentInvocations;
+};
+
+/* Adds the lifetime of the object to the referenced milliseconds counter */
+class ScopedTimer
+{
+    private:
+        std::chrono::steady_clock::time_point   m_start;
+        double &                                m_targetMs;
+
+    public:
+        explicit ScopedTimer(double & targetMs) : m_start(std::chrono::steady_clock::now()), m_targetMs(targetMs) {}
+        ~ScopedTimer()
+        {
+            m_targetMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+        }
+};
+
+/*
+ * Per frame CPU timers plus GPU timestamps and pipeline statistics around the render pass.
+ * Queries of a frame slot are read back after the slot's fence was waited for, so reading never stalls.
+ */
+class FrameProfiler
+{
+    private:
+        VkDevice                                m_device = VK_NULL_HANDLE;
+        VkQueryPool                             m_timestampPool = VK_NULL_HANDLE;
+        VkQueryPool                             m_statisticsPool = VK_NULL_HANDLE;
+        VkQueryPipelineStatisticFlags           m_statisticsFlags = 0;
+        double                                  m_timestampPeriod = 1.0;    /* ns per tick */
+        uint64_t                                m_timestampMask = 0u;
+        bool                                    m_enabled = false;
+
+        std::string                             m_outputPath;
+        uint64_t                                m_frameNumber = 0u;
+        std::chrono::steady_clock::time_point   m_frameStart;
+        FrameRecord                             m_current;
+        std::vector<FrameRecord>                m_pending;                  /* submitted, results not read yet, one per frame slot */
+        std::vector<bool>                       m_pendingValid;
+        std::vector<FrameRecord>                m_records;                  /* completed frames */
+
+    public:
+        void init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t timestampValidBits, uint32_t frameSlots,
+                  bool pipelineStatistics, const std::string & outputPath);
+        bool isEnabled(void) { return m_enabled; }
+        VkQueryPipelineStatisticFlags getPipelineStatisticsFlags(void) { return m_statisticsFlags; }
+
+        void beginFrame(void);
+        double & cpuTime(eCpuTimer timer) { return m_current.cpuMs[timer]; }
+        void resolve(uint32_t slot);
+        void endFrame(uint32_t slot);
+
+        void cmdBegin(VkCommandBuffer commandBuffer, uint32_t slot);
+        void cmdEnd(VkCommandBuffer commandBuffer, uint32_t slot);
+
+        void printSummary(void);
+        void exportRecords(void);
+        void destroy(void);
+};
+#endif
@@ -0,0 +1,32 @@
+#include <stdexcept>
+#include "shader_code.hpp"
+
+void ShaderCode::setEmbedded(const uint32_t * code, size_t size)
+{
+    release();
+    m_code = code;
+    m_size = size;
+}
+
+void ShaderCode::mapFile(const std::string & path)
+{
+    release();
+
+    /* Mapped read-only, the pages are page aligned so they can be passed as pCode without copying */
+    m_file.map(path);
+    m_code = reinterpret_cast<const uint32_t *>(m_file.data());
+    m_size = m_file.size();
+
+    if ((0u != (m_size % sizeof(uint32_t))) || (SPIRV_MAGIC != m_code[0]))
+    {
+        release();
+        throw std::runtime_error("Not a SPIR-V binary!");
+    }
+}
+
+void ShaderCode::release(void)
+{
+    m_file.release();
+    m_code = nullptr;
+    m_size = 0u;
+}
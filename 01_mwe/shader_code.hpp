@@ -0,0 +1,29 @@
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "mapped_file.hpp"
+
+#ifndef SHADER_CODE_GUARD
+#define SHADER_CODE_GUARD
+
+#define SPIRV_MAGIC     0x07230203u
+
+/* SPIR-V words for vkCreateShaderModule, either built into the executable or memory-mapped from a .spv file */
+class ShaderCode
+{
+    private:
+        const uint32_t *    m_code = nullptr;
+        size_t              m_size = 0u;        /* bytes */
+        MappedFile          m_file;
+
+    public:
+        void setEmbedded(const uint32_t * code, size_t size);
+        void mapFile(const std::string & path);
+
+        const uint32_t * data(void) { return m_code; }
+        size_t size(void) { return m_size; }
+
+        void release(void);
+};
+#endif
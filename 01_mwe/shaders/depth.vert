@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+/* Depth pre-pass, positions only; the transform has to stay identical to shader.vert */
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 mvp;
+} ubo;
+
+layout(location = 0) in vec4 position;
+layout(location = 2) in vec4 instanceOffset;    /* xyz translation, w scale */
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = ubo.mvp * vec4(position.xyz * instanceOffset.w + instanceOffset.xyz, 1.0);
+}
\ No newline at end of file
@@ -1,10 +1,10 @@
-#version 450
-#extension GL_ARB_separate_shader_objects : enable
-#extension GL_ARB_shading_language_420pack : enable
-
-layout (location = 0) in vec4 color;
-layout (location = 0) out vec4 outColor;
-void main()
-{
-    outColor = color;
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+layout (location = 0) in vec4 color;
+layout (location = 0) out vec4 outColor;
+void main()
+{
+    outColor = color;
 }
\ No newline at end of file
@@ -1,11 +1,20 @@
-#version 450
-#extension GL_ARB_separate_shader_objects : enable
-
-layout(location = 0) in vec4 position;
-layout(location = 1) in vec4 inColor;
-layout(location = 0) out vec4 fragColor;
-
-void main() {
-    gl_Position = position;
-    fragColor = inColor;
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 mvp;
+} ubo;
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec4 instanceOffset;    /* xyz translation, w scale */
+layout(location = 3) in vec4 instanceColor;
+layout(location = 0) out vec4 fragColor;
+
+/* The depth pre-pass (depth.vert) must produce bit identical depth for the EQUAL test */
+invariant gl_Position;
+
+void main() {
+    gl_Position = ubo.mvp * vec4(position.xyz * instanceOffset.w + instanceOffset.xyz, 1.0);
+    fragColor = inColor * instanceColor;
 }
\ No newline at end of file
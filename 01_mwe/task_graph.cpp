@@ -0,0 +1,128 @@
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include "task_graph.hpp"
+
+uint32_t TaskGraph::addTask(const std::string & name, const std::function<void(void)> & function,
+                            const std::vector<uint32_t> & dependencies, bool mainThread)
+{
+    uint32_t index = (uint32_t) m_tasks.size();
+
+    for (auto dependency : dependencies)
+    {
+        if (dependency >= index)
+        {
+            throw std::runtime_error("Task graph dependency on a task that was not added yet!");
+        }
+        m_tasks[dependency].dependents.push_back(index);
+    }
+
+    m_tasks.push_back({name, function, {}, (uint32_t) dependencies.size(), mainThread, 0.0, 0.0});
+    return index;
+}
+
+void TaskGraph::execute(bool mainThread)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        /* Workers never take main thread tasks, the main thread takes both kinds */
+        m_changed.wait(lock, [&] {
+            return (0u == m_remainingTasks) || (nullptr != m_error) || !m_ready.empty() || (mainThread && !m_readyMainThread.empty());
+        });
+        if ((0u == m_remainingTasks) || (nullptr != m_error))
+        {
+            return;
+        }
+
+        std::vector<uint32_t> & queue = (mainThread && !m_readyMainThread.empty()) ? m_readyMainThread : m_ready;
+        uint32_t index = queue.back();
+        queue.pop_back();
+        GraphTask & task = m_tasks[index];
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            task.function();
+        }
+        catch (...)
+        {
+            lock.lock();
+            if (nullptr == m_error)
+            {
+                m_error = std::current_exception();
+            }
+            m_changed.notify_all();
+            return;
+        }
+        auto end = std::chrono::steady_clock::now();
+        task.startMs = std::chrono::duration<double, std::milli>(start - m_start).count();
+        task.durationMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        lock.lock();
+        m_remainingTasks--;
+        for (auto dependent : task.dependents)
+        {
+            if (0u == --m_remainingDependencies[dependent])
+            {
+                (m_tasks[dependent].mainThread ? m_readyMainThread : m_ready).push_back(dependent);
+            }
+        }
+        m_changed.notify_all();
+    }
+}
+
+void TaskGraph::run(ThreadPool & pool)
+{
+    m_remainingTasks = (uint32_t) m_tasks.size();
+    m_remainingDependencies.resize(m_tasks.size());
+    m_ready.clear();
+    m_readyMainThread.clear();
+    m_error = nullptr;
+
+    /* Pushed in reverse so independent tasks start in the order they were added */
+    for (uint32_t i = (uint32_t) m_tasks.size(); i > 0u; i--)
+    {
+        m_remainingDependencies[i - 1u] = m_tasks[i - 1u].dependencyCount;
+        if (0u == m_tasks[i - 1u].dependencyCount)
+        {
+            (m_tasks[i - 1u].mainThread ? m_readyMainThread : m_ready).push_back(i - 1u);
+        }
+    }
+
+    m_start = std::chrono::steady_clock::now();
+
+    std::function<void(uint32_t)> worker = [this](uint32_t) { execute(false); };
+    if (pool.isInitialized())
+    {
+        pool.dispatch(pool.getThreadCount(), worker);
+    }
+    execute(true);
+    if (pool.isInitialized())
+    {
+        pool.wait();
+    }
+
+    m_wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+
+    if (nullptr != m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+}
+
+void TaskGraph::printTimings(void)
+{
+    double serialMs = 0.0;
+
+    std::cout << "Initialization tasks (start + duration ms):" << std::endl;
+    for (const auto & task : m_tasks)
+    {
+        std::cout << "  " << std::left << std::setw(24) << task.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(9) << task.startMs << " + " << std::setw(8) << task.durationMs << std::endl;
+        serialMs += task.durationMs;
+    }
+    std::cout << "Initialization wall time " << m_wallMs << " ms, sum of tasks " << serialMs << " ms" << std::defaultfloat << std::endl;
+}
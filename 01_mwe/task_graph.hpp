@@ -0,0 +1,57 @@
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+
+#include "thread_pool.hpp"
+
+#ifndef TASK_GRAPH_GUARD
+#define TASK_GRAPH_GUARD
+
+struct GraphTask
+{
+    std::string                 name;
+    std::function<void(void)>   function;
+    std::vector<uint32_t>       dependents;
+    uint32_t                    dependencyCount;
+    bool                        mainThread;         /* e.g. GLFW calls, only run by the thread calling run() */
+    double                      startMs;            /* relative to the start of run() */
+    double                      durationMs;
+};
+
+/*
+ * Tasks with explicit dependencies, a task starts as soon as all tasks it depends on have finished.
+ * Dependencies can only point to tasks added earlier, so the graph is acyclic by construction.
+ */
+class TaskGraph
+{
+    private:
+        std::vector<GraphTask>                  m_tasks;
+        std::vector<uint32_t>                   m_remainingDependencies;
+        std::vector<uint32_t>                   m_ready;
+        std::vector<uint32_t>                   m_readyMainThread;
+        uint32_t                                m_remainingTasks = 0u;
+        std::exception_ptr                      m_error;
+        std::mutex                              m_mutex;
+        std::condition_variable                 m_changed;
+        std::chrono::steady_clock::time_point   m_start;
+        double                                  m_wallMs = 0.0;
+
+        void execute(bool mainThread);
+
+    public:
+        uint32_t addTask(const std::string & name, const std::function<void(void)> & function,
+                         const std::vector<uint32_t> & dependencies = {}, bool mainThread = false);
+
+        /* Runs the graph on the pool's workers and the calling thread, rethrows the first exception of a task */
+        void run(ThreadPool & pool);
+
+        const std::vector<GraphTask> & getTasks(void) { return m_tasks; }
+        double getWallMs(void) { return m_wallMs; }
+        void printTimings(void);
+};
+#endif
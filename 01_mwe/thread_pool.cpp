@@ -0,0 +1,123 @@
+#include "thread_pool.hpp"
+
+void ThreadPool::init(uint32_t threadCount)
+{
+    if (!m_workers.empty())
+    {
+        return;
+    }
+
+    /* 0 means one worker per hardware thread */
+    if (0u == threadCount)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (0u == threadCount)
+    {
+        threadCount = 1u;
+    }
+
+    m_stop = false;
+    for (uint32_t i = 0u; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+uint32_t ThreadPool::getThreadCount(void)
+{
+    return (uint32_t) m_workers.size();
+}
+
+void ThreadPool::workerLoop(void)
+{
+    uint64_t generation = 0u;
+
+    while (true)
+    {
+        const std::function<void(uint32_t)> * job;
+        uint32_t taskCount;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || (generation != m_generation); });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+            job = m_job;
+            taskCount = m_taskCount;
+            m_activeWorkers++;
+        }
+
+        /* Tasks are handed out one by one, fast workers simply take more of them */
+        for (uint32_t task = m_nextTask.fetch_add(1u); task < taskCount; task = m_nextTask.fetch_add(1u))
+        {
+            (*job)(task);
+            m_remainingTasks.fetch_sub(1u);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_activeWorkers--;
+        }
+        m_done.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(uint32_t taskCount, const std::function<void(uint32_t)> & task)
+{
+    if (0u == taskCount)
+    {
+        return;
+    }
+
+    if (m_workers.empty())
+    {
+        for (uint32_t i = 0u; i < taskCount; i++)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    dispatch(taskCount, task);
+    wait();
+}
+
+void ThreadPool::dispatch(uint32_t taskCount, const std::function<void(uint32_t)> & task)
+{
+    {
+        /* A late worker may still hold the previous job, it must leave the task loop before the counters are reset */
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [&] { return 0u == m_activeWorkers; });
+        m_job = &task;
+        m_taskCount = taskCount;
+        m_nextTask = 0u;
+        m_remainingTasks = taskCount;
+        m_generation++;
+    }
+    m_wake.notify_all();
+}
+
+void ThreadPool::wait(void)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return (0u == m_remainingTasks) && (0u == m_activeWorkers); });
+    m_job = nullptr;
+}
+
+void ThreadPool::destroy(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto & worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
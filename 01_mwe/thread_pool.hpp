@@ -0,0 +1,44 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+
+#ifndef THREAD_POOL_GUARD
+#define THREAD_POOL_GUARD
+
+/* Fixed set of worker threads executing indexed tasks, parallelFor() blocks until all of them are done */
+class ThreadPool
+{
+    private:
+        std::vector<std::thread>                    m_workers;
+        std::mutex                                  m_mutex;
+        std::condition_variable                     m_wake;
+        std::condition_variable                     m_done;
+
+        const std::function<void(uint32_t)> *       m_job = nullptr;
+        uint32_t                                    m_taskCount = 0u;
+        std::atomic<uint32_t>                       m_nextTask{0u};
+        std::atomic<uint32_t>                       m_remainingTasks{0u};
+        uint32_t                                    m_activeWorkers = 0u;
+        uint64_t                                    m_generation = 0u;
+        bool                                        m_stop = false;
+
+        void workerLoop(void);
+
+    public:
+        void init(uint32_t threadCount);
+        bool isInitialized(void) { return !m_workers.empty(); }
+        uint32_t getThreadCount(void);
+
+        void parallelFor(uint32_t taskCount, const std::function<void(uint32_t)> & task);
+
+        /* Non-blocking half of parallelFor(), the caller may do other work before wait(); task must outlive wait() */
+        void dispatch(uint32_t taskCount, const std::function<void(uint32_t)> & task);
+        void wait(void);
+
+        void destroy(void);
+};
+#endif
@@ -0,0 +1,120 @@
+#include "vertex_format.hpp"
+#include "vertex_transform.hpp"
+#include "glm/glm/gtc/matrix_transform.hpp"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+/*
+ * CPU transform micro-benchmark, no Vulkan device needed.
+ * The baseline is the per-vertex loop main.cpp used to run (mat4 * Vertex::coord over an array of structures),
+ * it is compared against the structure of arrays batch kernels the CPU supports.
+ */
+
+static double bestOf(uint32_t repeats, const std::function<void(void)> & work)
+{
+    double bestMs = 1e30;
+    for (uint32_t i = 0u; i < repeats; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        bestMs = (ms < bestMs) ? ms : bestMs;
+    }
+    return bestMs;
+}
+
+int main(int argc, char ** argv)
+{
+    size_t vertexCount = 1u << 20;
+    uint32_t repeats = 20u;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((0 == strcmp(argv[i], "--vertices")) && ((i + 1) < argc))
+        {
+            vertexCount = (size_t) strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((0 == strcmp(argv[i], "--repeats")) && ((i + 1) < argc))
+        {
+            repeats = (uint32_t) strtoul(argv[++i], nullptr, 10);
+        }
+    }
+
+    if (0u == repeats)
+    {
+        repeats = 1u;
+    }
+
+    glm::mat4 camera = glm::perspective(glm::radians(45.0f), 640.f / 480.f, 0.1f, 100.0f)
+                     * glm::lookAt(glm::vec3(0.f, 2.f, 5.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+
+    /* Same positions in both layouts, deterministic so runs are comparable */
+    std::vector<Vertex> vertices(vertexCount);
+    std::vector<Vertex> transformed(vertexCount);
+    std::vector<float> inX(vertexCount), inY(vertexCount), inZ(vertexCount);
+    std::vector<float> outX(vertexCount), outY(vertexCount), outZ(vertexCount), outW(vertexCount);
+    uint32_t seed = 0x12345678u;
+    for (size_t i = 0u; i < vertexCount; i++)
+    {
+        float coord[3];
+        for (auto & c : coord)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            c = (float) (seed >> 8) / (float) (1u << 24) * 2.f - 1.f;
+        }
+        vertices[i] = {glm::vec4(coord[0], coord[1], coord[2], 1.f), glm::vec4(1.f)};
+        inX[i] = coord[0];
+        inY[i] = coord[1];
+        inZ[i] = coord[2];
+    }
+
+    PositionStreams input = {inX.data(), inY.data(), inZ.data()};
+    TransformedStreams output = {outX.data(), outY.data(), outZ.data(), outW.data()};
+
+    double baselineMs = bestOf(repeats, [&]
+    {
+        for (size_t i = 0u; i < vertexCount; i++)
+        {
+            transformed[i].coord = camera * vertices[i].coord;
+        }
+    });
+
+    std::cout << "Vertices: " << vertexCount << ", best of " << repeats << " runs, dispatch picks " << getTransformKernelName(getBestTransformKernel()) << std::endl;
+    std::cout << "  aos glm loop: " << baselineMs << " ms, " << (vertexCount / baselineMs / 1000.0) << " Mvertices/s" << std::endl;
+
+    for (int kernel = TRANSFORM_KERNEL_SCALAR; kernel < TRANSFORM_KERNEL_COUNT; kernel++)
+    {
+        eTransformKernel transformKernel = (eTransformKernel) kernel;
+        if (!isTransformKernelSupported(transformKernel))
+        {
+            std::cout << "  " << getTransformKernelName(transformKernel) << ": not supported" << std::endl;
+            continue;
+        }
+
+        double ms = bestOf(repeats, [&]
+        {
+            transformPositions(transformKernel, camera, input, output, vertexCount);
+        });
+
+        /* FMA kernels round differently from glm, report the largest deviation from the reference loop */
+        float maxError = 0.f;
+        for (size_t i = 0u; i < vertexCount; i++)
+        {
+            const glm::vec4 & reference = transformed[i].coord;
+            maxError = fmaxf(maxError, fabsf(outX[i] - reference.x));
+            maxError = fmaxf(maxError, fabsf(outY[i] - reference.y));
+            maxError = fmaxf(maxError, fabsf(outZ[i] - reference.z));
+            maxError = fmaxf(maxError, fabsf(outW[i] - reference.w));
+        }
+
+        std::cout << "  soa " << getTransformKernelName(transformKernel) << ": " << ms << " ms, " << (vertexCount / ms / 1000.0) << " Mvertices/s, "
+                  << (baselineMs / ms) << "x, max error " << maxError << std::endl;
+    }
+
+    return 0;
+}
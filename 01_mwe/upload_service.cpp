@@ -0,0 +1,367 @@
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+#include "upload_service.hpp"
+
+void UploadService::init(VkPhysicalDevice physicalDevice, VkDevice device, DeviceMemoryAllocator & allocator, VkQueue queue,
+                         uint32_t transferFamily, uint32_t graphicsFamily)
+{
+    VkResult result;
+
+    m_device = device;
+    m_allocator = &allocator;
+    m_queue = queue;
+    m_transferFamily = transferFamily;
+    m_graphicsFamily = graphicsFamily;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    /* Command buffers are reused batch after batch, vkBeginCommandBuffer resets them */
+    VkCommandPoolCreateInfo cpci =
+    {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext              = nullptr,
+        .flags              = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex   = m_transferFamily,
+    };
+
+    result = vkCreateCommandPool(m_device, &cpci, nullptr, &m_commandPool);
+    if (VK_SUCCESS != result)
+    {
+        throw std::runtime_error("Unable to create upload command pool!");
+    }
+
+    std::cout << "Uploads on queue family " << std::dec << m_transferFamily
+              << (hasOwnershipTransfer() ? " with ownership transfer" : ", shared with graphics") << std::endl;
+}
+
+uint32_t UploadService::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties)
+{
+    for (uint32_t i = 0u; i < m_memoryProperties.memoryTypeCount; i++)
+    {
+        if ((0u != (typeBits & (1u << i))) &&
+            (properties == (m_memoryProperties.memoryTypes[i].propertyFlags & properties)))
+        {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("Unable to find suitable memory type!");
+}
+
+void UploadService::beginBatch(void)
+{
+    if (!m_free.empty())
+    {
+        m_recording = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        VkCommandBufferAllocateInfo cbai =
+        {
+            .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext              = nullptr,
+            .commandPool        = m_commandPool,
+            .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1u,
+        };
+        VkFenceCreateInfo fci =
+        {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+        };
+        VkSemaphoreCreateInfo sci =
+        {
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+        };
+
+        m_recording = UploadBatch();
+        vkAllocateCommandBuffers(m_device, &cbai, &m_recording.commandBuffer);
+        vkCreateFence(m_device, &fci, nullptr, &m_recording.fence);
+        vkCreateSemaphore(m_device, &sci, nullptr, &m_recording.semaphore);
+    }
+
+    m_recording.ticket = m_nextTicket++;
+
+    VkCommandBufferBeginInfo cbbi =
+    {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext              = nullptr,
+        .flags              = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo   = nullptr,
+    };
+    vkBeginCommandBuffer(m_recording.commandBuffer, &cbbi);
+}
+
+void UploadService::retireBatches(void)
+{
+    /*
+     * A batch is done once its copies finished and, when it was acquired, the acquiring submission finished too;
+     * only then its semaphore is unsignaled with no pending wait and the staging memory is unused
+     */
+    for (size_t i = 0u; i < m_submitted.size();)
+    {
+        UploadBatch & batch = m_submitted[i];
+        bool done = (VK_SUCCESS == vkGetFenceStatus(m_device, batch.fence)) &&
+                    batch.acquired && (VK_SUCCESS == vkGetFenceStatus(m_device, batch.acquireFence));
+        if (!done)
+        {
+            i++;
+            continue;
+        }
+
+        for (size_t b = 0u; b < batch.stagingBuffers.size(); b++)
+        {
+            vkDestroyBuffer(m_device, batch.stagingBuffers[b], nullptr);
+            m_allocator->free(batch.stagingMemory[b]);
+        }
+        batch.stagingBuffers.clear();
+        batch.stagingMemory.clear();
+        batch.acquireBarriers.clear();
+        batch.dstStages = 0;
+        batch.dstAccess = 0;
+        batch.acquireFence = VK_NULL_HANDLE;
+        batch.acquired = false;
+        vkResetFences(m_device, 1u, &batch.fence);
+
+        m_free.push_back(batch);
+        m_submitted.erase(m_submitted.begin() + i);
+    }
+}
+
+uint64_t UploadService::upload(VkBuffer buffer, VkDeviceSize offset, const void * data, VkDeviceSize size,
+                               VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    return upload(buffer, offset, size, [data, size](void * staging) { memcpy(staging, data, (size_t) size); }, dstStage, dstAccess);
+}
+
+uint64_t UploadService::upload(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const std::function<void(void * staging)> & fill,
+                               VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    VkResult result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (VK_NULL_HANDLE == m_recording.commandBuffer)
+    {
+        retireBatches();
+        beginBatch();
+    }
+
+    /* Host visible staging copy, freed once the batch retired */
+    VkBuffer stagingBuffer;
+    VkBufferCreateInfo bci =
+    {
+        .sType                  = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .pNext                  = nullptr,
+        .flags                  = 0,
+        .size                   = size,
+        .usage                  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .sharingMode            = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount  = 0u,
+        .pQueueFamilyIndices    = nullptr,
+    };
+    result = vkCreateBuffer(m_device, &bci, nullptr, &stagingBuffer);
+    if (VK_SUCCESS != result)
+    {
+        throw std::runtime_error("Unable to create staging buffer!");
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(m_device, stagingBuffer, &memoryRequirements);
+    MemoryAllocation stagingMemory = m_allocator->allocate(memoryRequirements,
+        findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        SUBALLOCATION_LINEAR);
+    vkBindBufferMemory(m_device, stagingBuffer, stagingMemory.memory, stagingMemory.offset);
+    fill(stagingMemory.mapped);
+
+    m_recording.stagingBuffers.push_back(stagingBuffer);
+    m_recording.stagingMemory.push_back(stagingMemory);
+
+    VkBufferCopy region = {.srcOffset = 0u, .dstOffset = offset, .size = size};
+    vkCmdCopyBuffer(m_recording.commandBuffer, stagingBuffer, buffer, 1u, &region);
+
+    /* Release half of the ownership transfer, the acquire half is recorded on the graphics queue */
+    if (hasOwnershipTransfer())
+    {
+        VkBufferMemoryBarrier release =
+        {
+            .sType                  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext                  = nullptr,
+            .srcAccessMask          = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask          = 0,
+            .srcQueueFamilyIndex    = m_transferFamily,
+            .dstQueueFamilyIndex    = m_graphicsFamily,
+            .buffer                 = buffer,
+            .offset                 = offset,
+            .size                   = size,
+        };
+        vkCmdPipelineBarrier(m_recording.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0u, nullptr, 1u, &release, 0u, nullptr);
+
+        VkBufferMemoryBarrier acquire = release;
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = dstAccess;
+        m_recording.acquireBarriers.push_back(acquire);
+    }
+    m_recording.dstStages |= dstStage;
+    m_recording.dstAccess |= dstAccess;
+
+    return m_recording.ticket;
+}
+
+uint64_t UploadService::flush(void)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (VK_NULL_HANDLE == m_recording.commandBuffer)
+    {
+        return 0u;
+    }
+
+    vkEndCommandBuffer(m_recording.commandBuffer);
+
+    VkSubmitInfo submitInfo =
+    {
+        .sType                  = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                  = nullptr,
+        .waitSemaphoreCount     = 0u,
+        .pWaitSemaphores        = nullptr,
+        .pWaitDstStageMask      = nullptr,
+        .commandBufferCount     = 1u,
+        .pCommandBuffers        = &m_recording.commandBuffer,
+        .signalSemaphoreCount   = 1u,
+        .pSignalSemaphores      = &m_recording.semaphore,
+    };
+
+    VkResult result = vkQueueSubmit(m_queue, 1u, &submitInfo, m_recording.fence);
+    if (VK_SUCCESS != result)
+    {
+        throw std::runtime_error("Unable to submit uploads!");
+    }
+
+    uint64_t ticket = m_recording.ticket;
+    m_submitted.push_back(m_recording);
+    m_recording = UploadBatch();
+
+    return ticket;
+}
+
+bool UploadService::isComplete(uint64_t ticket)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (ticket == m_recording.ticket)
+    {
+        return false;
+    }
+    for (auto & batch : m_submitted)
+    {
+        if (ticket == batch.ticket)
+        {
+            return VK_SUCCESS == vkGetFenceStatus(m_device, batch.fence);
+        }
+    }
+
+    /* Retired */
+    return true;
+}
+
+void UploadService::wait(uint64_t ticket)
+{
+    VkFence fence = VK_NULL_HANDLE;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (ticket == m_recording.ticket)
+        {
+            throw std::runtime_error("Waiting for an upload batch that was not flushed!");
+        }
+        for (auto & batch : m_submitted)
+        {
+            if (ticket == batch.ticket)
+            {
+                fence = batch.fence;
+            }
+        }
+    }
+
+    /* Only the copies are waited for, the buffers still need to be acquired on the graphics queue */
+    if (VK_NULL_HANDLE != fence)
+    {
+        vkWaitForFences(m_device, 1u, &fence, VK_TRUE, UINT64_MAX);
+    }
+}
+
+void UploadService::acquire(VkCommandBuffer commandBuffer, VkFence submissionFence,
+                            std::vector<VkSemaphore> & waitSemaphores, std::vector<VkPipelineStageFlags> & waitStages)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    retireBatches();
+
+    for (auto & batch : m_submitted)
+    {
+        if (batch.acquired)
+        {
+            continue;
+        }
+
+        /*
+         * Only this submission waits for the semaphore. The barrier starts at the wait stages, so it chains off the
+         * wait, and its second scope orders every later submission on the queue after the copies as well. Between
+         * different families the barriers also move the buffers to the graphics family.
+         */
+        if (!batch.acquireBarriers.empty())
+        {
+            vkCmdPipelineBarrier(commandBuffer, batch.dstStages, batch.dstStages, 0,
+                                 0u, nullptr, (uint32_t) batch.acquireBarriers.size(), batch.acquireBarriers.data(), 0u, nullptr);
+        }
+        else
+        {
+            VkMemoryBarrier barrier =
+            {
+                .sType          = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                .pNext          = nullptr,
+                .srcAccessMask  = 0,
+                .dstAccessMask  = batch.dstAccess,
+            };
+            vkCmdPipelineBarrier(commandBuffer, batch.dstStages, batch.dstStages, 0, 1u, &barrier, 0u, nullptr, 0u, nullptr);
+        }
+        waitSemaphores.push_back(batch.semaphore);
+        waitStages.push_back(batch.dstStages);
+
+        batch.acquired = true;
+        batch.acquireFence = submissionFence;
+    }
+}
+
+void UploadService::destroy(void)
+{
+    /* Called after the device is idle */
+    if (VK_NULL_HANDLE != m_recording.commandBuffer)
+    {
+        vkEndCommandBuffer(m_recording.commandBuffer);
+        m_submitted.push_back(m_recording);
+        m_recording = UploadBatch();
+    }
+
+    m_submitted.insert(m_submitted.end(), m_free.begin(), m_free.end());
+    m_free.clear();
+
+    for (auto & batch : m_submitted)
+    {
+        for (size_t b = 0u; b < batch.stagingBuffers.size(); b++)
+        {
+            vkDestroyBuffer(m_device, batch.stagingBuffers[b], nullptr);
+            m_allocator->free(batch.stagingMemory[b]);
+        }
+        vkDestroyFence(m_device, batch.fence, nullptr);
+        vkDestroySemaphore(m_device, batch.semaphore, nullptr);
+    }
+    m_submitted.clear();
+
+    vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+    m_commandPool = VK_NULL_HANDLE;
+}
@@ -0,0 +1,75 @@
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "memory_allocator.hpp"
+
+#ifndef UPLOAD_SERVICE_GUARD
+#define UPLOAD_SERVICE_GUARD
+
+/* Staging copies recorded into one transfer command buffer and submitted together */
+struct UploadBatch
+{
+    VkCommandBuffer                     commandBuffer = VK_NULL_HANDLE;
+    VkFence                             fence = VK_NULL_HANDLE;         /* signaled once the copies are done */
+    VkSemaphore                         semaphore = VK_NULL_HANDLE;     /* waited by the graphics submission acquiring the buffers */
+    uint64_t                            ticket = 0u;
+    std::vector<VkBuffer>               stagingBuffers;
+    std::vector<MemoryAllocation>       stagingMemory;
+    std::vector<VkBufferMemoryBarrier>  acquireBarriers;                /* graphics queue half of the ownership transfers */
+    VkPipelineStageFlags                dstStages = 0;
+    VkAccessFlags                       dstAccess = 0;
+    VkFence                             acquireFence = VK_NULL_HANDLE;  /* fence of the graphics submission that waited for the batch */
+    bool                                acquired = false;
+};
+
+/*
+ * Uploads buffers on the transfer queue. Copies are batched until flush(), the graphics side picks up every
+ * submitted batch in acquire() by waiting for its semaphore on the GPU, so neither queue nor the render loop blocks.
+ */
+class UploadService
+{
+    private:
+        VkDevice                            m_device = VK_NULL_HANDLE;
+        DeviceMemoryAllocator *             m_allocator = nullptr;
+        VkPhysicalDeviceMemoryProperties    m_memoryProperties;
+        VkQueue                             m_queue = VK_NULL_HANDLE;
+        uint32_t                            m_transferFamily = 0u;
+        uint32_t                            m_graphicsFamily = 0u;
+        VkCommandPool                       m_commandPool = VK_NULL_HANDLE;
+        std::mutex                          m_mutex;    /* uploads may come from several threads */
+
+        UploadBatch                         m_recording;    /* commandBuffer stays VK_NULL_HANDLE until the first copy */
+        std::vector<UploadBatch>            m_submitted;    /* in submission order */
+        std::vector<UploadBatch>            m_free;         /* command buffers, fences and semaphores for reuse */
+        uint64_t                            m_nextTicket = 1u;
+
+        uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties);
+        void beginBatch(void);
+        void retireBatches(void);
+
+    public:
+        void init(VkPhysicalDevice physicalDevice, VkDevice device, DeviceMemoryAllocator & allocator, VkQueue queue,
+                  uint32_t transferFamily, uint32_t graphicsFamily);
+        bool hasOwnershipTransfer(void) { return m_transferFamily != m_graphicsFamily; }
+
+        /* Returns the ticket of the batch the copy went into, the buffer must not be used before that batch is acquired */
+        uint64_t upload(VkBuffer buffer, VkDeviceSize offset, const void * data, VkDeviceSize size,
+                        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+        /* Same, fill writes the size bytes into the mapped staging memory, e.g. to convert without an intermediate copy */
+        uint64_t upload(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, const std::function<void(void * staging)> & fill,
+                        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+        uint64_t flush(void);
+        bool isComplete(uint64_t ticket);
+        void wait(uint64_t ticket);
+
+        /* Records the acquire barriers of all submitted batches and returns the semaphores the submission has to wait for */
+        void acquire(VkCommandBuffer commandBuffer, VkFence submissionFence,
+                     std::vector<VkSemaphore> & waitSemaphores, std::vector<VkPipelineStageFlags> & waitStages);
+
+        void destroy(void);
+};
+#endif
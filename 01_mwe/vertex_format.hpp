@@ -0,0 +1,215 @@
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+#include "glm/glm/vec4.hpp"
+#include "glm/glm/gtc/packing.hpp"
+
+#ifndef VERTEX_FORMAT_GUARD
+#define VERTEX_FORMAT_GUARD
+
+#define USE_GLM
+
+/* Authoring layout, models are described in this format and converted to GpuVertex on upload */
+#if defined USE_GLM
+struct Vertex
+{
+    glm::vec4 coord;
+    glm::vec4 color;
+};
+#else
+struct Vertex
+{
+    struct
+    {
+        float x;
+        float y;
+        float z;
+        float w;
+    } coord;
+    struct
+    {
+        float r;
+        float g;
+        float b;
+        float a;
+    } color;
+};
+#endif
+
+/* Half float position (w = 1) and RGBA8 color, 12 bytes */
+struct VertexHalf
+{
+    uint16_t coord[4];
+    uint8_t  color[4];
+};
+
+/* Normalized 16 bit position (w = 1) and RGBA8 color, 12 bytes.
+ * Positions are divided by the mesh's largest coordinate, the vertex shader gets it back through the model matrix. */
+struct VertexSnorm16
+{
+    int16_t  coord[4];
+    uint8_t  color[4];
+};
+
+static inline uint8_t packUnorm8(float value)
+{
+    value = (value < 0.f) ? 0.f : ((value > 1.f) ? 1.f : value);
+    return (uint8_t) roundf(value * 255.f);
+}
+
+/*
+ * Every GPU vertex layout specializes VertexFormatTraits with:
+ *  coordFormat/colorFormat     - formats of the two shader inputs
+ *  coordOffset/colorOffset     - offsets inside the vertex
+ *  coordSize                   - bytes of the position, the stride of the position-only stream
+ *  normalizedCoord             - positions have to be scaled into [-1, 1] before encoding
+ *  encode()                    - conversion from the authoring Vertex
+ */
+template <typename V>
+struct VertexFormatTraits;
+
+template <>
+struct VertexFormatTraits<Vertex>
+{
+    static constexpr const char *   name            = "R32G32B32A32_SFLOAT + R32G32B32A32_SFLOAT";
+    static constexpr VkFormat       coordFormat     = VK_FORMAT_R32G32B32A32_SFLOAT;
+    static constexpr VkFormat       colorFormat     = VK_FORMAT_R32G32B32A32_SFLOAT;
+    static constexpr uint32_t       coordOffset     = offsetof(Vertex, coord);
+    static constexpr uint32_t       colorOffset     = offsetof(Vertex, color);
+    static constexpr uint32_t       coordSize       = sizeof(Vertex::coord);
+    static constexpr bool           normalizedCoord = false;
+
+    static Vertex encode(const Vertex & in, float coordScale)
+    {
+        Vertex out = in;
+        out.coord.x *= coordScale;
+        out.coord.y *= coordScale;
+        out.coord.z *= coordScale;
+        return out;
+    }
+};
+
+template <>
+struct VertexFormatTraits<VertexHalf>
+{
+    static constexpr const char *   name            = "R16G16B16A16_SFLOAT + R8G8B8A8_UNORM";
+    static constexpr VkFormat       coordFormat     = VK_FORMAT_R16G16B16A16_SFLOAT;
+    static constexpr VkFormat       colorFormat     = VK_FORMAT_R8G8B8A8_UNORM;
+    static constexpr uint32_t       coordOffset     = offsetof(VertexHalf, coord);
+    static constexpr uint32_t       colorOffset     = offsetof(VertexHalf, color);
+    static constexpr uint32_t       coordSize       = sizeof(VertexHalf::coord);
+    static constexpr bool           normalizedCoord = false;
+
+    static VertexHalf encode(const Vertex & in, float coordScale)
+    {
+        VertexHalf out;
+        out.coord[0] = glm::packHalf1x16(in.coord.x * coordScale);
+        out.coord[1] = glm::packHalf1x16(in.coord.y * coordScale);
+        out.coord[2] = glm::packHalf1x16(in.coord.z * coordScale);
+        out.coord[3] = glm::packHalf1x16(1.f);
+        out.color[0] = packUnorm8(in.color.r);
+        out.color[1] = packUnorm8(in.color.g);
+        out.color[2] = packUnorm8(in.color.b);
+        out.color[3] = packUnorm8(in.color.a);
+        return out;
+    }
+};
+
+template <>
+struct VertexFormatTraits<VertexSnorm16>
+{
+    static constexpr const char *   name            = "R16G16B16A16_SNORM + R8G8B8A8_UNORM";
+    static constexpr VkFormat       coordFormat     = VK_FORMAT_R16G16B16A16_SNORM;
+    static constexpr VkFormat       colorFormat     = VK_FORMAT_R8G8B8A8_UNORM;
+    static constexpr uint32_t       coordOffset     = offsetof(VertexSnorm16, coord);
+    static constexpr uint32_t       colorOffset     = offsetof(VertexSnorm16, color);
+    static constexpr uint32_t       coordSize       = sizeof(VertexSnorm16::coord);
+    static constexpr bool           normalizedCoord = true;
+
+    static VertexSnorm16 encode(const Vertex & in, float coordScale)
+    {
+        VertexSnorm16 out;
+        out.coord[0] = (int16_t) glm::packSnorm1x16(in.coord.x * coordScale);
+        out.coord[1] = (int16_t) glm::packSnorm1x16(in.coord.y * coordScale);
+        out.coord[2] = (int16_t) glm::packSnorm1x16(in.coord.z * coordScale);
+        out.coord[3] = (int16_t) glm::packSnorm1x16(1.f);
+        out.color[0] = packUnorm8(in.color.r);
+        out.color[1] = packUnorm8(in.color.g);
+        out.color[2] = packUnorm8(in.color.b);
+        out.color[3] = packUnorm8(in.color.a);
+        return out;
+    }
+};
+
+template <typename V>
+VkVertexInputBindingDescription getVertexBindingDescription(uint32_t binding)
+{
+    return {.binding = binding, .stride = sizeof(V), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX};
+}
+
+template <typename V>
+std::array<VkVertexInputAttributeDescription, 2> getVertexAttributeDescriptions(uint32_t binding)
+{
+    return
+    {{
+        { .location = 0u, .binding = binding, .format = VertexFormatTraits<V>::coordFormat, .offset = VertexFormatTraits<V>::coordOffset},
+        { .location = 1u, .binding = binding, .format = VertexFormatTraits<V>::colorFormat, .offset = VertexFormatTraits<V>::colorOffset}
+    }};
+}
+
+/* Position-only stream for the depth pre-pass, the coordinates of every vertex packed back to back */
+template <typename V>
+VkVertexInputBindingDescription getPositionBindingDescription(uint32_t binding)
+{
+    return {.binding = binding, .stride = VertexFormatTraits<V>::coordSize, .inputRate = VK_VERTEX_INPUT_RATE_VERTEX};
+}
+
+template <typename V>
+VkVertexInputAttributeDescription getPositionAttributeDescription(uint32_t binding)
+{
+    return { .location = 0u, .binding = binding, .format = VertexFormatTraits<V>::coordFormat, .offset = 0u};
+}
+
+/* Per-instance attributes, fetched once per instance from vertex binding 1 */
+struct InstanceData
+{
+    glm::vec4 offsetScale;  /* xyz model space translation, w uniform scale */
+    glm::vec4 color;        /* multiplied with the vertex color */
+};
+
+static inline VkVertexInputBindingDescription getInstanceBindingDescription(uint32_t binding)
+{
+    return {.binding = binding, .stride = sizeof(InstanceData), .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE};
+}
+
+static inline std::array<VkVertexInputAttributeDescription, 2> getInstanceAttributeDescriptions(uint32_t binding, uint32_t firstLocation)
+{
+    return
+    {{
+        { .location = firstLocation,      .binding = binding, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(InstanceData, offsetScale)},
+        { .location = firstLocation + 1u, .binding = binding, .format = VK_FORMAT_R32G32B32A32_SFLOAT, .offset = offsetof(InstanceData, color)}
+    }};
+}
+
+/* Layout uploaded to the GPU, selected at build time (VERTEX_FORMAT in CMakeLists.txt) */
+#define VERTEX_FORMAT_F32       0
+#define VERTEX_FORMAT_HALF      1
+#define VERTEX_FORMAT_SNORM16   2
+
+#ifndef VERTEX_FORMAT
+#define VERTEX_FORMAT VERTEX_FORMAT_HALF
+#endif
+
+#if VERTEX_FORMAT == VERTEX_FORMAT_F32
+typedef Vertex GpuVertex;
+#elif VERTEX_FORMAT == VERTEX_FORMAT_HALF
+typedef VertexHalf GpuVertex;
+#elif VERTEX_FORMAT == VERTEX_FORMAT_SNORM16
+typedef VertexSnorm16 GpuVertex;
+#else
+#error "Unknown VERTEX_FORMAT"
+#endif
+#endif
@@ -0,0 +1,251 @@
+#include <stdexcept>
+#include "vertex_transform.hpp"
+#include "glm/glm/vec4.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TRANSFORM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TRANSFORM_TARGET(isa)
+#else
+#define TRANSFORM_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+static void transformScalar(const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t first, size_t count)
+{
+    for (size_t i = first; i < count; i++)
+    {
+        glm::vec4 position = matrix * glm::vec4(input.x[i], input.y[i], input.z[i], 1.f);
+        output.x[i] = position.x;
+        output.y[i] = position.y;
+        output.z[i] = position.z;
+        output.w[i] = position.w;
+    }
+}
+
+#if defined(TRANSFORM_X86)
+TRANSFORM_TARGET("sse2")
+static void transformSSE(const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count)
+{
+    /* glm is column major, m[c][r] holds element (r, c) broadcast to every lane, every lane is one position */
+    __m128 m[4][4];
+    for (int c = 0; c < 4; c++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            m[c][r] = _mm_set1_ps(matrix[c][r]);
+        }
+    }
+
+    size_t i = 0u;
+    for (; (i + 4u) <= count; i += 4u)
+    {
+        __m128 x = _mm_loadu_ps(input.x + i);
+        __m128 y = _mm_loadu_ps(input.y + i);
+        __m128 z = _mm_loadu_ps(input.z + i);
+
+        for (int r = 0; r < 4; r++)
+        {
+            __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][r], x), _mm_mul_ps(m[1][r], y)), _mm_add_ps(_mm_mul_ps(m[2][r], z), m[3][r]));
+            float * out = (0 == r) ? output.x : (1 == r) ? output.y : (2 == r) ? output.z : output.w;
+            _mm_storeu_ps(out + i, result);
+        }
+    }
+
+    transformScalar(matrix, input, output, i, count);
+}
+
+TRANSFORM_TARGET("avx2,fma")
+static void transformAVX2(const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count)
+{
+    __m256 m[4][4];
+    for (int c = 0; c < 4; c++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            m[c][r] = _mm256_set1_ps(matrix[c][r]);
+        }
+    }
+
+    size_t i = 0u;
+    for (; (i + 8u) <= count; i += 8u)
+    {
+        __m256 x = _mm256_loadu_ps(input.x + i);
+        __m256 y = _mm256_loadu_ps(input.y + i);
+        __m256 z = _mm256_loadu_ps(input.z + i);
+
+        for (int r = 0; r < 4; r++)
+        {
+            __m256 result = _mm256_fmadd_ps(m[0][r], x, _mm256_fmadd_ps(m[1][r], y, _mm256_fmadd_ps(m[2][r], z, m[3][r])));
+            float * out = (0 == r) ? output.x : (1 == r) ? output.y : (2 == r) ? output.z : output.w;
+            _mm256_storeu_ps(out + i, result);
+        }
+    }
+
+    transformScalar(matrix, input, output, i, count);
+}
+
+TRANSFORM_TARGET("avx512f")
+static void transformAVX512(const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count)
+{
+    __m512 m[4][4];
+    for (int c = 0; c < 4; c++)
+    {
+        for (int r = 0; r < 4; r++)
+        {
+            m[c][r] = _mm512_set1_ps(matrix[c][r]);
+        }
+    }
+
+    size_t i = 0u;
+    for (; (i + 16u) <= count; i += 16u)
+    {
+        __m512 x = _mm512_loadu_ps(input.x + i);
+        __m512 y = _mm512_loadu_ps(input.y + i);
+        __m512 z = _mm512_loadu_ps(input.z + i);
+
+        for (int r = 0; r < 4; r++)
+        {
+            __m512 result = _mm512_fmadd_ps(m[0][r], x, _mm512_fmadd_ps(m[1][r], y, _mm512_fmadd_ps(m[2][r], z, m[3][r])));
+            float * out = (0 == r) ? output.x : (1 == r) ? output.y : (2 == r) ? output.z : output.w;
+            _mm512_storeu_ps(out + i, result);
+        }
+    }
+
+    /* The remaining < 16 positions go through the masked tail instead of the scalar loop */
+    if (i < count)
+    {
+        __mmask16 mask = (__mmask16) ((1u << (count - i)) - 1u);
+        __m512 x = _mm512_maskz_loadu_ps(mask, input.x + i);
+        __m512 y = _mm512_maskz_loadu_ps(mask, input.y + i);
+        __m512 z = _mm512_maskz_loadu_ps(mask, input.z + i);
+
+        for (int r = 0; r < 4; r++)
+        {
+            __m512 result = _mm512_fmadd_ps(m[0][r], x, _mm512_fmadd_ps(m[1][r], y, _mm512_fmadd_ps(m[2][r], z, m[3][r])));
+            float * out = (0 == r) ? output.x : (1 == r) ? output.y : (2 == r) ? output.z : output.w;
+            _mm512_mask_storeu_ps(out + i, mask, result);
+        }
+    }
+}
+
+static bool isOsAvxStateEnabled(uint64_t stateMask)
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    /* OSXSAVE, without it XGETBV is not available */
+    if (0 == (info[2] & (1 << 27)))
+    {
+        return false;
+    }
+    return stateMask == (_xgetbv(0) & stateMask);
+#else
+    (void) stateMask;
+    /* __builtin_cpu_supports() already checks the XCR0 state */
+    return true;
+#endif
+}
+#endif
+
+static bool detectTransformKernel(eTransformKernel kernel)
+{
+#if defined(TRANSFORM_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    int extended[4];
+    __cpuid(info, 1);
+    __cpuidex(extended, 7, 0);
+    switch (kernel)
+    {
+        case TRANSFORM_KERNEL_SCALAR:    return true;
+        case TRANSFORM_KERNEL_SSE:       return 0 != (info[3] & (1 << 26));
+        case TRANSFORM_KERNEL_AVX2:      return (0 != (extended[1] & (1 << 5))) && (0 != (info[2] & (1 << 12))) && isOsAvxStateEnabled(0x6u);
+        case TRANSFORM_KERNEL_AVX512:    return (0 != (extended[1] & (1 << 16))) && isOsAvxStateEnabled(0xe6u);
+        default:                         return false;
+    }
+#else
+    __builtin_cpu_init();
+    switch (kernel)
+    {
+        case TRANSFORM_KERNEL_SCALAR:    return true;
+        case TRANSFORM_KERNEL_SSE:       return __builtin_cpu_supports("sse2");
+        case TRANSFORM_KERNEL_AVX2:      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && isOsAvxStateEnabled(0x6u);
+        case TRANSFORM_KERNEL_AVX512:    return __builtin_cpu_supports("avx512f") && isOsAvxStateEnabled(0xe6u);
+        default:                         return false;
+    }
+#endif
+#else
+    return TRANSFORM_KERNEL_SCALAR == kernel;
+#endif
+}
+
+bool isTransformKernelSupported(eTransformKernel kernel)
+{
+    /* CPUID is not free, detect once; transformPositions() asks on every call */
+    static const uint32_t supported = []
+    {
+        uint32_t mask = 0u;
+        for (int k = TRANSFORM_KERNEL_SCALAR; k < TRANSFORM_KERNEL_COUNT; k++)
+        {
+            mask |= detectTransformKernel((eTransformKernel) k) ? (1u << k) : 0u;
+        }
+        return mask;
+    }();
+
+    return ((int) kernel < TRANSFORM_KERNEL_COUNT) && (0u != (supported & (1u << kernel)));
+}
+
+eTransformKernel getBestTransformKernel(void)
+{
+    static const eTransformKernel best = []
+    {
+        for (int kernel = TRANSFORM_KERNEL_COUNT - 1; kernel > TRANSFORM_KERNEL_SCALAR; kernel--)
+        {
+            if (isTransformKernelSupported((eTransformKernel) kernel))
+            {
+                return (eTransformKernel) kernel;
+            }
+        }
+        return TRANSFORM_KERNEL_SCALAR;
+    }();
+
+    return best;
+}
+
+const char * getTransformKernelName(eTransformKernel kernel)
+{
+    switch (kernel)
+    {
+        case TRANSFORM_KERNEL_SCALAR:    return "scalar";
+        case TRANSFORM_KERNEL_SSE:       return "sse";
+        case TRANSFORM_KERNEL_AVX2:      return "avx2";
+        case TRANSFORM_KERNEL_AVX512:    return "avx512";
+        default:                         return "unknown";
+    }
+}
+
+void transformPositions(const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count)
+{
+    transformPositions(getBestTransformKernel(), matrix, input, output, count);
+}
+
+void transformPositions(eTransformKernel kernel, const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count)
+{
+    if (!isTransformKernelSupported(kernel))
+    {
+        throw std::runtime_error("Transform kernel not supported by this CPU!");
+    }
+
+    switch (kernel)
+    {
+#if defined(TRANSFORM_X86)
+        case TRANSFORM_KERNEL_SSE:      transformSSE(matrix, input, output, count);         break;
+        case TRANSFORM_KERNEL_AVX2:     transformAVX2(matrix, input, output, count);        break;
+        case TRANSFORM_KERNEL_AVX512:   transformAVX512(matrix, input, output, count);      break;
+#endif
+        default:                        transformScalar(matrix, input, output, 0u, count);  break;
+    }
+}
@@ -0,0 +1,43 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "glm/glm/mat4x4.hpp"
+
+#ifndef VERTEX_TRANSFORM_GUARD
+#define VERTEX_TRANSFORM_GUARD
+
+typedef enum
+{
+    TRANSFORM_KERNEL_SCALAR,    /* glm, the reference */
+    TRANSFORM_KERNEL_SSE,       /* 4 positions per iteration */
+    TRANSFORM_KERNEL_AVX2,      /* 8 positions per iteration, FMA */
+    TRANSFORM_KERNEL_AVX512,    /* 16 positions per iteration */
+    TRANSFORM_KERNEL_COUNT
+} eTransformKernel;
+
+/* Structure of arrays position streams, w is 1 for every input position */
+struct PositionStreams
+{
+    const float *   x;
+    const float *   y;
+    const float *   z;
+};
+
+/* Homogeneous results, e.g. clip space positions */
+struct TransformedStreams
+{
+    float *         x;
+    float *         y;
+    float *         z;
+    float *         w;
+};
+
+/* Kernels are compiled for their instruction set with target attributes, the fastest one the CPU and OS support is picked at run time */
+bool isTransformKernelSupported(eTransformKernel kernel);
+eTransformKernel getBestTransformKernel(void);
+const char * getTransformKernelName(eTransformKernel kernel);
+
+/* output = matrix * vec4(input, 1) for count positions, streams may be unaligned but must not overlap */
+void transformPositions(const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count);
+void transformPositions(eTransformKernel kernel, const glm::mat4 & matrix, const PositionStreams & input, const TransformedStreams & output, size_t count);
+#endif